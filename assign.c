@@ -8,7 +8,102 @@
        based on minimizing the difference between the institutional quotas and 
        the institutional assignments 
      If it is run with a seed index as the command line argument, it will give
-       a full output for that case. */ 
+       a full output for that case. 
+     With "batch SEEDS..." it gives the full output of each of a list of 
+       seeds, each in a directory of its own (see batch below).
+     With "sweep FILE" it scans variations of the quotas and requests of 
+       the input and compares them (see sweep below).
+     With "tune DIR..." it searches for constants of the heuristic that 
+       find good seeds with fewer seeds (see tuning below).
+     With "sensitivity SEEDS..." it solves the seeds again with each 
+       shifter removed or a constraint of theirs relaxed, and reports how
+       the outcome moves (see sensitivity below).
+
+   Options:
+     -p, --priority=POLICY  what to do with shifters who asked for special
+                            priority but have no entry in Pri.csv.  POLICY is
+                              ask         prompt for each one (the default 
+                                          when stdin is a terminal)
+                              fail        list all of them and stop (the 
+                                          default otherwise)
+                              default:P   give all of them base priority P
+                              table:FILE  look them up in FILE, a file in the
+                                          Pri.csv format
+                            The policy is applied once, before any seed is
+                            run, so a scan never stops to wait for input.
+     -t, --trace=FILE       write a binary trace of every decision of the 
+                            seeds that are reported (or of the seed that is
+                            run) to FILE
+         --trace-all        trace every seed of a scan, not just the 
+                            reported ones
+     -T, --decode=FILE      render the trace FILE as log text, for the seed
+                            index given or for every seed in it
+     -j, --profile=FILE     time the phases of each seed, count the main
+                            decisions, and write the totals to FILE as JSON
+         --perf             add hardware counters to the profile (Linux)
+     -e, --engine=ENGINE    fast (the default) or reference, the algorithm
+                            exactly as written; they give the same result
+     -n, --threads=N        run the seeds of a scan, or of a batch or a 
+                            sensitivity, in N threads 
+     -s, --serve=SOCKET     stay resident and answer requests on the Unix
+                            domain socket SOCKET (see serve below)
+     -w, --warm=DIR         after late changes to the input, repair the 
+                            best seeds of the run in DIR instead of a new
+                            scan (see warm start below)
+     -k, --top=K            keep the K best seeds of a scan (default 20),
+                            listed at its end and written to the results
+                            file
+     -o, --order=ORDER      how seeds rank: lex, by open shifts, then chisq,
+                            then chisqInd (the default), or W1,W2,W3, by 
+                            the lowest W1*open + W2*chisq + W3*chisqInd
+     -r, --results=FILE     the results file of a scan, CSV (default 
+                            TopSeeds.csv, or Sweep.csv for a sweep, 
+                            Tuned.txt for a tuning and Sensitivity.csv for
+                            a sensitivity)
+     -m, --metrics=FILE     record the metrics of every seed of a scan in
+                            FILE, a columnar binary file (see the metrics 
+                            file below, and readMetrics.py)
+     -S, --status=FILE      keep FILE up to date during a scan with the 
+                            rate and the distributions of the outcomes so 
+                            far, as JSON (see outcome statistics below)
+         --status-every=S   rewrite it every S seconds (default 10)
+     -b, --time-budget=S    stop a scan after S seconds; the seeds are 
+                            taken in order, so the scan covers 0 to the 
+                            last one reported at its end
+         --max-seeds=N      scan only the seeds 0 to N - 1
+                            A scan stopped by either, or by SIGINT or 
+                            SIGTERM, ends as a whole one does: the best 
+                            seeds so far, the results file, the status
+     -c, --checkpoint=FILE  save the progress of a scan in FILE (see 
+                            checkpoints below)
+         --checkpoint-every=S  every S seconds (default 60) and at its end
+         --resume           continue the scan saved in the checkpoint file
+         --shard=I/N        scan only the I-th of N equal blocks of seeds
+         --seeds=FIRST-LAST scan only the seeds FIRST to LAST
+                            The checkpoint of a block is its partial result
+                            (default Scan-FIRST-LAST.txt); "merge FILE..." 
+                            combines them (see shards below)
+         --param=NAME=VALUE set a constant of the heuristic, or all those
+                            in a file of NAME=VALUE lines (see tuning)
+         --candidates=N     sets of constants a tuning starts with 
+                            (default 32)
+         --branches=B       at the end of a scan, run LoP-2 and the 
+                            donation of each of the K best seeds B more 
+                            times with other random priorities, from 
+                            their state at the switch to LoP-2; the best
+                            of them are listed as SEED/BRANCH, which can
+                            be run as a seed (see branches below)
+         --priorities=TYPE  float (the default) or fixed: integer 
+                            priorities, the same on any machine (see 
+                            fixed point below)
+         --pattern=PATTERN  the shifts of a day: 8h, night, day and swing
+                            (the default), or 12h, night and day (see 
+                            shift patterns below)
+         --rules=RULES      the rules of who may take a shift: icarus (the
+                            default) or nova (see rules below)
+
+   The algorithm is also a library, with main left out (see assign.h), and
+   a Python module (see assignmodule.c). */ 
 
 /* The program requires 4 files:
      Pri.cvs    A file with the individual special priorities
@@ -19,7 +114,59 @@
                /* Dependency Table
 
 main
-  prepareRandomSeeds        // prepare 1,000,000 seeds
+  startWriter               // starts the background output writer
+  loadProblem               // reads the input once into a problem
+    prepareRandomSeeds      // prepare 1,000,000 seeds
+    setPolicy               // the -p option
+    resolvePriorities       // settle missing special priorities up front
+      parseInstFile, parseShiftFile, parsePriFile, parseIndFile (see below)
+      readPriorities        // reads a fallback priority table
+      missingReport         // lists every shifter without a priority
+      teeDrain              // the console is out before the user is asked
+    the 4 parse routines and listRequests (listCandidates, the presolve
+                            // of the fast engine, and listPartners, its
+                            // tables of consecutive shifts)
+  solveSeed                 // runs one seed: loadSeed (initialization,
+                            // the 4 parse routines and listRequests for
+                            // the fast engine), then runSeed: algorithm
+                            // and runLoP2: switchLoP, algorithm and 
+                            // donationTime
+  presolveReport            // what the presolve of the fast engine found
+  solveBranches             // --branches: snapshots at switchLoP, then
+                            // runLoP2 with other random priorities
+  writeResults              // the best seeds of a scan (solverBest)
+  saveScan, loadScan        // checkpoints of a scan: takeState, resumeState
+  mergeScans                // merge: the partial results of shards
+  runBatch                  // batch: full output of a list of seeds
+    batchSeeds              // seeds, ranges and results files
+      uniqueSeeds           // each once, by sorting 
+    batchSeed               // solveSeed and the tables, in Seed-NNNNNN
+  runSweep                  // sweep: scans of variations of the input
+    sweepVariant            // copyProblem, setQuota and setRequest, then
+                            // solveRange over the seeds
+  runSensitivity            // sensitivity: each shifter changed in turn
+    sensitivityThread       // copyProblem, sensitivityChange (setRequestOf
+                            // for a removal), solveProblem, and back
+  runTune                   // tune: successive halving of sets of the
+                            // constants of the heuristic
+    scoreCandidate          // solveRange over more seeds of each input
+  serve                     // the daemon: a problem and a solver kept
+                            // for the requests on a socket
+    serveRun                // solveSeed and the tables for a connection
+    serveScan               // solveRange, reports as they are found
+  warmStart                 // --warm: late changes to an earlier run
+    readResults             // the seeds of its results file
+    diffProblems            // what changed in the input
+    repairSeed              // its best seed, kept where nothing changed
+  solveRange                // runs the seeds of a scan in the threads
+                            // of the solver (newSolver starts them)
+    solveOne                // one seed of a problem without the files:
+      solveProblem          // startSeed, which copies the problem and
+                            // draws the priorities, then runSeed
+      takeResult            // report, into a result
+    recordMetrics           // into the metrics file (solverMetrics)
+    recordOutcome           // into the histograms of the thread; 
+                            // solverStatus merges and writes them
   initialization
   parseInstFile             // input institution file
     clearBuffer             // clears temporary buffer                         
@@ -28,34 +175,43 @@ main
     clearBuffer             // clears temporary buffer                         
     readBuffer              // reads an entry from the buffer     
   parsePriFile              // input priority file
-    clearBuffer             // clears temporary buffer                
-    readBuffer              // reads an entry from the buffer            
+    readPriorities          // reads a file in the Pri.csv format
+      clearBuffer           // clears temporary buffer                
+      readBuffer            // reads an entry from the buffer            
   parseIndFile              // input shifter file from the questionnaire
     clearBuffer             // clears temporary buffer
     readBuffer              // reads an entry from the buffer
-    randP                   // returns a random priority    
+    findPriority            // looks up Pri.csv and the resolved priorities
+    drawRandPri             // randP, or its fixed point form (randP 
+                            // returns a random priority)
+    sumPri                  // totPri, and the key with fixed point
   algorithm                 // run the assignment algorithm   
     prepareShifts           // finds requester info for all open shifts
       qualified             // determines if a shifter is qualified 
+        qualifiedBy         // the checks, under the rule set
       dumpPreparedShifts    // debugging tool; not normally called
     findNextShift           // picks next shift to be filled
     findConsecShift         // deals with consecutive shift requests
       prepareConsecutive    // makes decisons on consecutive shift requests
       assignShift           // does the paper work
         killInst            // removes institutional priority
+        cautioned           // whether an institution is cautioned
         cautionInst         // sets caution flag 
     assignShift             // does the paper work
       killInst              // removes institutional priority
+      cautioned             // whether an institution is cautioned
       cautionInst           // sets caution flag  
     getNewRandPri           // generates new random priorities
-      randP                 // returns a random priority 
+      drawRandPri, sumPri   // as in parseIndFile
   switchLoP                 // switch active file to LoP-2                  
   donationTime              // wealthy groups donate to the poor ones
     findDonors              // sets donor list and priorities
     findNextDonor           // finds the next potential donor from the list
     findReceiver            // finds a receiver
+      findReceiverBy        // the search, under the rule set
       assignDonorShift      // does the paper work
         killInst            // removes institutional priority
+        cautioned           // whether an institution is cautioned
         cautionInst         // sets a caution flag
         findDonors          // resets donor list and priorities          
   shiftTable                // print shift table and ECL input file
@@ -63,14 +219,51 @@ main
   institutionTable          // print institution table
     deficiencyReport        // prints deficiency reports online
     report                  // calculate final metrics  
-  report                    // calculate final metrics           */
+  report                    // calculate final metrics           
+  traceSeed                 // writes the decision trace of a seed
+  decodeTrace               // renders a trace file as log text
+  stopWriter                // writes out what is left of the output
+
+  All output goes through tee (console and a file) or put (a file only),
+  which format each line once for the background writer.           */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
+#include <unistd.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "assign.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef NSHIFTS          // may be set on the command line, e.g. -DNSHIFTS=156
 //#define  NSHIFTS 156        // number of shifts this period
 #define  NSHIFTS 90        // number of shifts this period
+#endif
+
+// capacities; they may also be set on the command line 
+
+#ifndef MAXIND
+#define MAXIND 250       // most individuals (and priority entries) 
+#endif
+#ifndef MAXINST
+#define MAXINST 50       // most institutions 
+#endif
+#ifndef MAXASSIGNED
+#define MAXASSIGNED 20   // most shifts assigned to one individual 
+#endif
+#define BUFFER (1024 + 8*NSHIFTS)  // bytes in the line buffer 
 
 // codes for base priority 
 
@@ -96,31 +289,69 @@ main
 
 typedef enum {false,true} bool;
 
+/* The constants of the heuristic can be changed at run time with --param
+   NAME=VALUE (see tuning below).  By default they are the values it was
+   written with, and the results are the same bit for bit. */
+
+typedef enum {TN_VIRGIN, TN_EXTRA_V, TN_BONUS_KEPT, TN_BONUS_OTHERS, 
+              TN_CAUTION, TN_DONOR, TN_RECEIVER, TN_RECEIVER_SHIFTS, TN_RAND,
+              NTUNING} tuningType;
+const char *tuningName[NTUNING] = {"virgin", "extraVirgin", "bonusKept",
+  "bonusOthers", "caution", "donor", "receiver", "receiverShifts", "rand"};
+const double tuningDefault[NTUNING] = {VIRGIN, EXTRA_V, 0.5, 0.1, 0, 10, 
+  10, 2, 1};
+                          // the bounds a tuning draws within 
+const double tuningLow[NTUNING] = {0, 0, 0, 0, 1, 1, 1, 0, 0.25};
+const double tuningHigh[NTUNING] = {1, 1, 1, 0.3, 20, 20, 20, 5, 2};
+const bool tuningInteger[NTUNING] = {false, false, false, false, true, 
+  true, true, true, false};
+
+double tuning[NTUNING] = {   /* virgin and extraVirgin: VIRGIN and EXTRA_V
+                                bonusKept: kept of the bonus priority by
+                                  who gets a shift (assignShift)
+                                bonusOthers: added to the other requesters
+                                caution: the points short of its quota 
+                                  when an institution is cautioned, and the 
+                                  largest shift its shifters then get in 
+                                  LoP-1; 0 => those of the rule set
+                                donor: weight of the institutional excess 
+                                  of a donor (findDonors)
+                                receiver, receiverShifts: weights of the
+                                  institutional deficit and of the shifts 
+                                  of a receiver (findReceiver)
+                                rand: scale of the random priority */
+  VIRGIN, EXTRA_V, 0.5, 0.1, 0, 10, 10, 2, 1};
+
+/* The state of a seed is thread local, so that each thread of a solver 
+   (see assign.h) runs seeds of its own.  The settings and the tables 
+   that are filled once before any seed is run stay global. */
+
 int directedShifts[10] = {-1};  /* directed shifts are shifts that need
                                    to be run first to be filled */
 bool defRep = false;     // output deficiency reports 
-bool  verbose = false;   /* It will be set to false for looping over random 
-                             seed */
+_Thread_local bool verbose = false;  /* It will be set to false for looping 
+                                        over random seed */
 int nDumpShift = 0;     // number of prepared shifts to be dumped for debug 
 int tDumpShift = 0;     // number of times prepared shifts will be dumped  
-char buffer[1024];      // general purpose buffer for temporary file storage 
+_Thread_local char buffer[BUFFER];  // general purpose buffer for temporary 
+                                    // file storage 
 
-bool lop1 = true;       // flag to indicate which LoP is active 
-int donorShift;         /* global parameter to simplify communication in the 
-                           donation section */
-bool noMultiPoint = false;   /* global parameter to simplify communication in 
-                             // consecutive shift section */
-FILE *fl;               //  pointer to the log
+_Thread_local bool lop1 = true;  // flag to indicate which LoP is active 
+_Thread_local int donorShift;  /* global parameter to simplify communication 
+                                 in the donation section */
+_Thread_local bool noMultiPoint = false;  /* global parameter to simplify 
+                                communication in consecutive shift section */
+_Thread_local FILE *fl; //  pointer to the log
 
 // total quantities
 
-int totShifters;
-int totShifts;
-int totPoints;
-int totRequests;
-int totQuotas; 
+_Thread_local int totShifters;
+_Thread_local int totShifts;
+_Thread_local int totPoints;
+_Thread_local int totRequests;
+_Thread_local int totQuotas; 
 
-struct individual {
+_Thread_local struct individual {
   char name[80];
   char ECLID[80];
   char email[80];
@@ -142,26 +373,29 @@ struct individual {
   int nLoP2;               // numbr of LoP2 requests  
   float basePri;           // base priority  
   float virginPri;         // virgin priority  
+  bool extraVirgin;        // asked for the extra virginity bonus 
   float bonusPri;          // bonus priority  
   float randPri;           // random priority  
   float totPri;            // total priority sum of the 3 above   
+  int fixBonus;            // bonusPri and randPri in fixed point 
+  int fixRand;
   int nPAssigned;          // shift points assigned  
   int nSAssigned;          // shifts assigned  
-  int assigned[20];        // shift numbers of assigned shifts  
+  int assigned[MAXASSIGNED];  // shift numbers of assigned shifts  
   bool open;               // 1 = open; 0 = closed (i.e. points assigned)
   bool caution;            // 1 => institution is within 1 of its quota  
-} ind[250];    
-  int nInd = -1;           // number of individuals  
+} ind[MAXIND];    
+  _Thread_local int nInd = -1;   // number of individuals  
 
-struct institution {
+_Thread_local struct institution {
   char name[20];
   int quota;
   int nPRequested;         // number of points requested by individuals  
   int nPAssigned;          // number of points assigned  
-} inst[50];      
-  int nInst = 0;           // number of institutions  
+} inst[MAXINST];      
+  _Thread_local int nInst = 0;   // number of institutions  
 
-struct shifts {
+_Thread_local struct shifts {
   bool open;               // 1 = open; 0 = closed  
   char date[8];
   char type[8];
@@ -170,39 +404,184 @@ struct shifts {
   char ECLDate[12];        // for ECL input, e.g. 2016-10-03  
   int points;              // number of shift points   
   int nRequests;           // number of requesters  
-  int requesters[100];     // requester numbers  
+  int requesters[MAXIND];  // requester numbers  
   int topRequester;        // highest priority requester  
   int assigned;            // assigned requester  
   int donPri;              // donation priority   
 } shift[NSHIFTS];
-int nShift = -1;           // index of shifts {0...(NSHIFTS -1)}  
+_Thread_local int nShift = -1;  // index of shifts {0...(NSHIFTS -1)}  
 
 // Global struct for base priorities  
 
-struct priority {
+_Thread_local struct priority {
   char ECLID[80];
   float basePri;         // base priority  
-} pri[250];
-int nPri = -1;
+} pri[MAXIND];
+_Thread_local int nPri = -1;
+
+// Special priorities missing from Pri.csv; settled once by resolvePriorities
+
+typedef enum {ASK, FAIL, DEFAULT, TABLE} priorityPolicy;
+priorityPolicy priPolicy;  // what to do about a missing priority 
+float priDefault;          // base priority for the DEFAULT policy 
+char priTable[256];        // fallback file for the TABLE policy 
+struct priority resolved[MAXIND];  // priorities settled by the policy 
+int nResolved = -1;
+bool resolving = false;    // parseIndFile only records missing priorities 
+int missing[MAXIND];       // shifters without a priority 
+int nMissing = 0;
 
 // Globals for readBuffer  
 
 typedef enum {INTEGER,STRING} typeCalledFor;
-int bIndex;         // current buffer location  
-int nChar;          // number of buffer bytes for current field  
-int iValue;         // integer return  
-char sValue[80];    // string return
-
-int nextShift;  // global for findNextShift  
+_Thread_local int bIndex;       // current buffer location  
+_Thread_local int nChar;        // number of buffer bytes for current field  
+_Thread_local int iValue;       // integer return  
+_Thread_local char sValue[80];  // string return
+
+_Thread_local int nextShift;  // global for findNextShift  
+
+/* Engines.  The reference engine is the algorithm as written.  The fast
+   engine makes the same decisions with less work.  A presolve 
+   (listRequests) lists for each shift the shifters who could ever be 
+   qualified for it, at each LoP: those who asked for it, asked for 
+   points at all, and asked for as many as the shift has or allow 
+   overage; at LoP-1 only those with a positive base priority as well, 
+   since it never rises (a zero quota sets it to 0, and killInst only 
+   lowers it).  prepareShifts and findReceiver only look at those, in 
+   shifter order as before.  Nobody is renumbered: the shifters left out 
+   still draw their random priorities, and the distances between shifts
+   are the ones the rest rules use, so the indices of the lists are the
+   original ones.  equiv.c checks the two engines against each other. */
+
+typedef enum {REFERENCE, FAST} engineType;
+_Thread_local engineType engine = FAST;
+_Thread_local int nAsked[NSHIFTS];  // number who could take each shift 
+_Thread_local int asked[NSHIFTS][MAXIND];  // who they are, in shifter order 
+_Thread_local int nAsked1[NSHIFTS];        // the same at LoP-1 
+_Thread_local int asked1[NSHIFTS][MAXIND];
+bool fixedPri = false;     // fixed point priorities (see fixed point) 
+_Thread_local unsigned long long priKey[MAXIND];  // their keys, by shifter 
+
+/* Rules.  The rules of who may take a shift differ between experiments,
+   so they are a rule set, chosen with --rules from ruleSets:
+
+     icarus   the rules the program was written with (the default)
+     nova     NOvA's: an institution is cautioned one point short of its
+              quota, and its shifters then get no multipoint shift at 
+              LoP-1 (the lines left commented out where ICARUS's 10 is)
+
+   The checks are written once, as inline functions of a rule set 
+   (qualifiedBy, findReceiverBy).  qualified and findReceiver call them 
+   with each rule set of ruleSets as a constant, so the compiler makes a
+   copy for each with its rules folded in, and with any other rule set 
+   (a library's own, say) as a variable, a generic copy; only the choice
+   of the copy is made at run time.  The presolve, findDonors and the 
+   cautioning of an institution read the rule set as it is, since they are
+   not hot, so a rule set is set before a problem is read.  Another 
+   experiment's rules go in a rule set of their own, added to ruleSets and
+   to the choices of qualified and findReceiver; equiv -u checks the 
+   copies against each other. */
+
+struct rules {
+  const char *name;
+  const char *pattern;     // the shift pattern, unless --pattern is given 
+  int days[4];             /* days between two shifts of a shifter at 
+                              least, and with nonConsec 2, 3 and 4 */
+  bool overage;            // NO_OVERAGE keeps a shifter within the request
+  bool zeroBaseWaits;      // a base priority of 0 waits for LoP-2 
+  bool caution;            /* the shifters of a cautioned institution get 
+                              no shift over cautionShort points at LoP-1 */
+  int cautionShort;        /* the points short of its quota when an 
+                              institution is cautioned (see cautioned) */
+  int consecKept;          /* a strict consecutive shifter keeps a shift
+                              within this many days of another from the 
+                              donation; 0 => none */
+  bool receiverRest;       // a receiver of a donation keeps days[0] too 
+};
+static const struct rules icarusRules = {"icarus", "8h", {1, 2, 3, 5}, 
+  true, true, true, 10, 2, false};
+static const struct rules novaRules = {"nova", "8h", {1, 2, 3, 5}, 
+  true, true, true, 1, 2, false};
+const struct rules *const ruleSets[] = {&icarusRules, &novaRules};
+#define NRULESETS (int)(sizeof(ruleSets)/sizeof(ruleSets[0]))
+const struct rules *rules = &icarusRules;
+
+bool setRules(const char *name) {  // false if there is no such rule set 
+  for (int k = 0; k < NRULESETS; k++) 
+    if (strcmp(ruleSets[k]->name, name) == 0) {
+      rules = ruleSets[k];
+      return true;
+    }
+  return false;
+}
 
-// Global struct for consecutive shift finding */
+static inline double cautionShort(const struct rules *r) {
+  return tuning[TN_CAUTION] > 0 ? tuning[TN_CAUTION] : r->cautionShort;
+}
 
-const int conIndex[3][6] = {  // list of possiblee consecutive shift   
-  {-3,3,4,5,-2,0},      // distances with a minimum of 16 hours rest   
-  {-3,3,-4,4,-2,2},     // for the 4 and 8 hours rest for the 5th and or 6th  
-  {-3,3,-4,-5,2,0}      // The first index is the type of shift  
+/* Shift patterns.  The shifts of a day come in a fixed order, and the
+   consecutive shifts of a shift are the ones around it at distances that
+   depend on its type and on the rest the shifter needs.  A pattern gives
+   those distances, most wanted first, and how many of them each rest 
+   allows; the rest rules of qualified are whole days of its shifts.  
+   --pattern picks one:
+
+     8h    night, day and swing, 3 shifts of 8 hours (the default)
+     12h   night and day, 2 shifts of 12 hours: the same shift a day 
+           before or after is 12 hours of rest, so only with short rest;
+           the other one is 24 
+
+   The fast engine looks the candidates up in tables made once from the
+   shift file (listPartners): for each shift and rest, the candidates in
+   bounds, and for each shift the shifts of its type and points, the only
+   ones a trade can give. */
+
+struct pattern {
+  const char *name;
+  int types;               // stype is 0 to types - 1 in Shift.csv 
+  int perDay;              // shifts a day 
+  int distance[3][6];      // to the consecutive candidates, by type 
+  int nCand[3][2];         // candidates, by type, with long or short rest 
+};
+const struct pattern patterns[] = {
+  {"8h", 3, 3, {
+    {-3,3,4,5,-2,0},       // distances with a minimum of 16 hours rest   
+    {-3,3,-4,4,-2,2},      // for the 4 and 8 hours rest for the 5th and or 6th  
+    {-3,3,-4,-5,2,0}},     // The first index is the type of shift  
+   {{4, 5}, {4, 6}, {4, 5}}},  // day gets another with 8 hours rest 
+  {"12h", 2, 2, {
+    {-3,3,-2,2},           // night: the days around it, then the nights 
+    {-3,3,-2,2}},          // day: the nights around it, then the days 
+   {{2, 4}, {2, 4}}}
 };
-struct consecutive {
+#define NPATTERNS (int)(sizeof(patterns)/sizeof(patterns[0]))
+const struct pattern *pattern = &patterns[0];
+int dayGap[4] = {3, 6, 9, 15};  // the days of the rules, in shifts 
+
+bool setPattern(const char *name) {  // false if there is no such pattern 
+  for (int k = 0; k < NPATTERNS; k++) 
+    if (strcmp(patterns[k].name, name) == 0) {
+      pattern = &patterns[k];
+      for (int g = 0; g < 4; g++) dayGap[g] = rules->days[g]*pattern->perDay;
+      return true;
+    }
+  return false;
+}
+
+_Thread_local struct neighbors {  // the tables of the fast engine 
+  struct {
+    int n;                 // candidates searched 
+    int shift[6];          // each one, or -1 out of bounds 
+  } partners[NSHIFTS][2];  // by shift and short rest 
+  int tradeFirst[NSHIFTS]; /* the shifts of the same type and points as 
+                              each, tradeList[tradeFirst] to */
+  int tradeEnd[NSHIFTS];   // tradeList[tradeEnd - 1], in shift order 
+  int tradeList[NSHIFTS];
+} neighbors;
+
+// Global struct for consecutive shift finding */
+_Thread_local struct consecutive {
   int nCand;            // number of candidate shifts  
   int shift[6];         // possible consecutive shifts  
   bool requested[6];    // shift has been requested  
@@ -215,6 +594,178 @@ struct consecutive {
   int tradeShift;       // trade shift assigned  
 } con;
 
+/* Binary decision trace.  Every decision of a seed is recorded as a 
+   12 byte event in a per-thread ring buffer.  At the end of the seed the
+   events are either written to the trace file (the seeds a scan reports, 
+   or every seed with --trace-all) or simply dropped, so the trace is 
+   cheap enough to leave on during a scan.  decodeTrace renders the trace
+   in the words of the log. */
+
+typedef enum {EV_LOP, EV_CONSEC, EV_ASSIGN, EV_TRADE, EV_KILL, EV_CAUTION,
+              EV_DONATE} eventType;
+
+struct event {
+  unsigned char type;      // eventType 
+  unsigned char aux;       /* EV_LOP: 1, 2, or 3 for donations; EV_CONSEC:
+                              return code of findConsecShift, 5 when a 
+                              consecutive shift was found; EV_ASSIGN: call
+                              type of assignShift + 16*con.decision */
+  unsigned short shift;    // shift number 
+  unsigned short who;      // individual, or institution for EV_KILL/CAUTION
+  unsigned short other;    /* EV_ASSIGN, EV_TRADE: qualified requesters;
+                              EV_DONATE: the receiver */
+  float value;             // priority of who, or the quota difference 
+};
+
+struct traceBlock {        // precedes the events of a seed in the file 
+  int seedIndex;
+  int nEvents;
+  int dropped;             // oldest events lost when the ring overflowed 
+};
+
+#define RING 16384         // events per ring buffer; a power of 2 
+#define TRACE_MAGIC 0x43525453  // "STRC" 
+
+_Thread_local struct event ring[RING];
+_Thread_local int ringCount = 0;   // events recorded for this seed 
+bool tracing = false;      // record events at all 
+bool traceAll = false;     // write every seed, not just the reported ones 
+FILE *ft;                  // pointer to the trace file 
+pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline void trace(eventType type, int aux, int is, int who, int other,
+                         float value) {
+  if (! tracing) return;
+  struct event *e = &ring[ringCount++ & (RING - 1)];
+  e->type = type;
+  e->aux = aux;
+  e->shift = is;
+  e->who = who;
+  e->other = other;
+  e->value = value;
+}
+
+/* Instrumentation.  With --profile=FILE each thread accumulates the time
+   spent in each phase of a seed and counts of the main decisions, and 
+   the totals are dumped as JSON at the end of the run.  With --perf the 
+   phases also get Linux hardware counters.  Phases are inclusive: the 
+   consecutive phase contains the assignments it makes.  When profiling 
+   is off each probe is a single test of a global flag. */
+
+typedef enum {PH_PARSE, PH_PREPARE, PH_NEXT, PH_CONSEC, PH_ASSIGN, 
+              PH_DONATION, PH_REPORT, NPHASES} phaseType;
+const char *phaseName[NPHASES] = {"parse", "prepareShifts", "findNextShift",
+  "findConsecShift", "assignShift", "donationTime", "report"};
+
+typedef enum {CT_SEEDS, CT_ASSIGN, CT_TRADE, CT_RECYCLE, CT_DONATION, 
+              CT_QUALIFIED, NCOUNTERS} counterType;
+const char *counterName[NCOUNTERS] = {"seeds", "assignments", "trades",
+  "recycles", "donations", "qualified"};
+
+#define NHW 4              // hardware counters per phase 
+const char *hwName[NHW] = {"cycles", "instructions", "cacheMisses", 
+  "branchMisses"};
+
+struct profile {
+  long calls[NPHASES];
+  double seconds[NPHASES];
+  long long hw[NPHASES][NHW];
+  long count[NCOUNTERS];
+};
+
+bool profiling = false;    // collect the profile 
+bool perfCounters = false; // with hardware counters 
+bool hwWorked = false;     // the hardware counters could be read 
+_Thread_local struct profile prof;   // this thread's accumulators 
+_Thread_local int seedCount[NCOUNTERS];  // the counts of the current seed 
+_Thread_local double phaseStarted[NPHASES];
+_Thread_local long long hwStarted[NPHASES][NHW];
+_Thread_local int perfFd = -2;       // hardware counter group; -1 if none 
+struct profile totalProf;  // merged from the threads by mergeProfile 
+pthread_mutex_t profLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*************************************************************************/
+double now() {             // seconds on the monotonic clock 
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+/*************************************************************************/
+bool readHw(long long *values) {  /* reads this thread's hardware counters;
+                                     opens them on first use */
+#ifdef __linux__
+  if (perfFd == -2) {
+    int config[NHW] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                       PERF_COUNT_HW_CACHE_MISSES, 
+                       PERF_COUNT_HW_BRANCH_MISSES};
+    perfFd = -1;
+    for (int ih = 0; ih < NHW; ih++) {
+      struct perf_event_attr pe;
+      memset(&pe, 0, sizeof(pe));
+      pe.type = PERF_TYPE_HARDWARE;
+      pe.size = sizeof(pe);
+      pe.config = config[ih];
+      pe.read_format = PERF_FORMAT_GROUP;
+      pe.exclude_kernel = 1;
+      pe.exclude_hv = 1;
+      int fd = syscall(SYS_perf_event_open, &pe, 0, -1, perfFd, 0);
+      if (fd < 0) {                  // not allowed or not supported 
+        if (perfFd >= 0) close(perfFd);
+        perfFd = -1;
+        break;
+      }
+      if (ih == 0) perfFd = fd;
+    }
+  }
+  if (perfFd < 0) return false;
+  long long group[NHW + 1];          // number of counters, then values 
+  if (read(perfFd, group, sizeof(group)) != sizeof(group)) return false;
+  memcpy(values, &group[1], sizeof(long long)*NHW);
+  hwWorked = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*************************************************************************/
+static inline void phaseStart(phaseType p) {
+  if (! profiling) return;
+  if (perfCounters) readHw(hwStarted[p]);
+  phaseStarted[p] = now();
+}
+
+/*************************************************************************/
+static inline void phaseStop(phaseType p) {
+  if (! profiling) return;
+  prof.seconds[p] += now() - phaseStarted[p];
+  prof.calls[p]++;
+  long long hw[NHW];
+  if (perfCounters && readHw(hw)) 
+    for (int ih = 0; ih < NHW; ih++) prof.hw[p][ih] += hw[ih] - hwStarted[p][ih];
+}
+
+/*************************************************************************/
+static inline void tally(counterType c) {
+  seedCount[c]++;
+  if (profiling) prof.count[c]++;
+}
+
+/*************************************************************************/
+void mergeProfile() {      // adds this thread's profile to the totals 
+  if (! profiling) return;
+  pthread_mutex_lock(&profLock);
+  for (int p = 0; p < NPHASES; p++) {
+    totalProf.calls[p] += prof.calls[p];
+    totalProf.seconds[p] += prof.seconds[p];
+    for (int ih = 0; ih < NHW; ih++) totalProf.hw[p][ih] += prof.hw[p][ih];
+  }
+  for (int c = 0; c < NCOUNTERS; c++) totalProf.count[c] += prof.count[c];
+  pthread_mutex_unlock(&profLock);
+  memset(&prof, 0, sizeof(prof));
+}
+
 /*
 Here is the plan:
 
@@ -227,6 +778,263 @@ Here is the plan:
 (5) output assignments and statistics
  */          
 
+/**************************************************************************/
+/* Output layer.  Everything that goes to the terminal, the log and the 
+   tables is formatted once by tee or put into a record of the current
+   chunk.  Full chunks are queued for a background writer thread, which 
+   writes each record to the console and/or its file, so the algorithm
+   never waits on printf or on the disk. */
+
+#define CHUNK 65536      // bytes of records per chunk 
+#define MAXCHUNKS 64     // queued chunks before the producer has to wait 
+
+FILE *console;           // terminal output; stdout 
+
+struct record {          // header of a record in a chunk 
+  FILE *f1;              // console or NULL 
+  FILE *f2;              // file or NULL 
+  int length;            // bytes of text that follow; -1 => fclose(f2) 
+};
+
+struct chunk {
+  struct chunk *next;
+  int used;              // bytes of records in data 
+  char data[CHUNK];
+};
+
+_Thread_local struct chunk *current;   /* chunk being filled; each thread
+                                          queues chunks of its own */
+_Thread_local bool quiet = false;  // tee goes to its file only 
+struct chunk *queueHead, *queueTail, *freeChunks;
+int nQueued = 0;
+bool writerStop = false;
+bool writerRunning = false;
+pthread_t writerThread;
+pthread_mutex_t writerLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t writerWake = PTHREAD_COND_INITIALIZER;  // work was queued 
+pthread_cond_t writerDone = PTHREAD_COND_INITIALIZER;  // a chunk was freed 
+
+/*************************************************************************/
+void *writer(void *arg) {  // the background writer thread 
+
+  (void)arg;
+  while (true) {
+    pthread_mutex_lock(&writerLock);
+    while (queueHead == NULL && ! writerStop) 
+      pthread_cond_wait(&writerWake, &writerLock);
+    struct chunk *ch = queueHead;
+    if (ch == NULL) {                   // stopped and nothing left 
+      pthread_mutex_unlock(&writerLock);
+      return NULL;
+    }
+    queueHead = ch->next;
+    if (queueHead == NULL) queueTail = NULL;
+    bool caughtUp = (queueHead == NULL);
+    pthread_mutex_unlock(&writerLock);
+
+    for (int at = 0; at < ch->used; ) {
+      struct record *r = (struct record *)&ch->data[at];
+      at += sizeof(struct record);
+      if (r->length < 0) {
+        fclose(r->f2);
+        continue;
+      }
+      if (r->f1) fwrite(&ch->data[at], 1, r->length, r->f1);
+      if (r->f2) fwrite(&ch->data[at], 1, r->length, r->f2);
+      at += (r->length + 7) & ~7;       // records stay aligned 
+    }
+    if (caughtUp) fflush(console);      // show what there is so far 
+
+    pthread_mutex_lock(&writerLock);
+    ch->next = freeChunks;
+    freeChunks = ch;
+    nQueued--;
+    pthread_cond_signal(&writerDone);
+    pthread_mutex_unlock(&writerLock);
+  }
+}
+
+/*************************************************************************/
+void queueChunk() {      // hands the current chunk to the writer 
+  if (current == NULL || current->used == 0) return;
+  pthread_mutex_lock(&writerLock);
+  current->next = NULL;
+  if (queueTail) queueTail->next = current;
+  else queueHead = current;
+  queueTail = current;
+  nQueued++;
+  pthread_cond_signal(&writerWake);
+  while (freeChunks == NULL && nQueued >= MAXCHUNKS)  // let it catch up 
+    pthread_cond_wait(&writerDone, &writerLock);
+  current = freeChunks;
+  if (current) freeChunks = current->next;
+  pthread_mutex_unlock(&writerLock);
+  if (current == NULL) current = malloc(sizeof(struct chunk));
+  current->used = 0;
+}
+
+/*************************************************************************/
+struct record *newRecord(FILE *f1, FILE *f2, int length) {
+  if (current == NULL) {
+    current = malloc(sizeof(struct chunk));
+    current->used = 0;
+  }
+  int need = sizeof(struct record) + ((length + 8) & ~7);
+  if (current->used + need > CHUNK) queueChunk();
+  struct record *r = (struct record *)&current->data[current->used];
+  r->f1 = f1;
+  r->f2 = f2;
+  r->length = length;
+  return r;
+}
+
+/*************************************************************************/
+void emit(FILE *f1, FILE *f2, const char *format, va_list ap) {
+
+  /* Formats straight into the current chunk.  Only when the text does not
+     fit in what is left of the chunk is it formatted a second time, into
+     a fresh chunk. */
+
+  va_list again;
+  va_copy(again, ap);
+  struct record *r = newRecord(f1, f2, 0);
+  char *text = (char *)(r + 1);
+  int room = CHUNK - current->used - sizeof(struct record);
+  int length = vsnprintf(text, room, format, ap);
+  if (length >= room) {
+    if (length >= CHUNK - (int)sizeof(struct record) - 8) 
+      length = CHUNK - sizeof(struct record) - 8;    // protection 
+    r = newRecord(f1, f2, length);
+    text = (char *)(r + 1);
+    vsnprintf(text, length + 1, format, again);
+  }
+  va_end(again);
+  r->length = length;
+  current->used += sizeof(struct record) + ((length + 7) & ~7);
+}
+
+/*************************************************************************/
+void tee(FILE *fp, const char *format, ...) { /* printf to the console and 
+                                                 fprintf to fp, if any */
+  va_list ap;
+  va_start(ap, format);
+  emit(quiet ? NULL : console, fp, format, ap);
+  va_end(ap);
+}
+
+/*************************************************************************/
+void put(FILE *fp, const char *format, ...) {  // fprintf to fp only 
+  va_list ap;
+  va_start(ap, format);
+  emit(NULL, fp, format, ap);
+  va_end(ap);
+}
+
+/*************************************************************************/
+void teeFlush() {        // hands what has been formatted to the writer now 
+  queueChunk();
+}
+
+/*************************************************************************/
+void teeDrain() {        /* teeFlush, and waits until the writer has put it 
+                            all out, e.g. before the console is read */
+  queueChunk();
+  if (! writerRunning) return;
+  pthread_mutex_lock(&writerLock);
+  while (nQueued > 0) pthread_cond_wait(&writerDone, &writerLock);
+  pthread_mutex_unlock(&writerLock);
+}
+
+/*************************************************************************/
+void teeClose(FILE *fp) { // closes fp after what was queued for it is out 
+  newRecord(NULL, fp, -1);
+  current->used += sizeof(struct record);
+}
+
+/*************************************************************************/
+size_t solverStackSize() {  /* the thread local state of a seed is kept 
+                               with the stack of a thread */
+  return (8 << 20) + sizeof(ind) + sizeof(shift) + 2*sizeof(asked) + 
+    sizeof(pri) + sizeof(ring);
+}
+
+/*************************************************************************/
+void startThread(pthread_t *thread, void *(*run)(void *), void *arg) {
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, solverStackSize());
+  int failed = pthread_create(thread, &attr, run, arg);
+  pthread_attr_destroy(&attr);
+  if (failed) {
+    fprintf(stderr, "\nCould not start a thread.\n");
+    exit(1);
+  }
+}
+
+/*************************************************************************/
+void startWriter() {
+  console = stdout;
+  writerRunning = true;
+  startThread(&writerThread, writer, NULL);
+}
+
+/*************************************************************************/
+void stopWriter() {      // writes everything that is left and stops 
+  if (! writerRunning) return;
+  queueChunk();
+  pthread_mutex_lock(&writerLock);
+  writerStop = true;
+  pthread_cond_signal(&writerWake);
+  pthread_mutex_unlock(&writerLock);
+  pthread_join(writerThread, NULL);
+  writerRunning = false;
+  fflush(console);
+}
+
+/**************************************************************************/
+/* Fatal errors stop the program with a message.  A library call that 
+   reads input (see loadProblem) sets onFatal and gets the message back 
+   as its error instead. */
+
+_Thread_local jmp_buf *onFatal;  // where to go instead of stopping 
+_Thread_local char *fatalText;   // and where the message goes then 
+_Thread_local int fatalSize;
+
+void fatal(int status, const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  if (onFatal) {
+    vsnprintf(fatalText, fatalSize, format, ap);
+    va_end(ap);
+    longjmp(*onFatal, 1);
+  }
+  emit(console, NULL, format, ap);
+  va_end(ap);
+  exit(status);
+}
+
+/**************************************************************************/
+/* Inputs.  The 4 input files are read from inputDir, or from text in 
+   memory when a problem is built by parseProblem. */
+
+typedef enum {INST_FILE, SHIFT_FILE, PRI_FILE, IND_FILE} inputType;
+const char *inputName[4] = {"Inst.csv", "Shift.csv", "Pri.csv", "Ind.csv"};
+_Thread_local const char *inputDir = ".";
+_Thread_local const char *inputText[4];   // NULL => read the file 
+
+FILE *openInput(inputType which) {
+  FILE *fp;
+  if (inputText[which]) 
+    fp = fmemopen((void *)inputText[which], strlen(inputText[which]), "r");
+  else {
+    char name[1024];
+    snprintf(name, sizeof(name), "%s/%s", inputDir, inputName[which]);
+    fp = fopen(name, "r");
+  }
+  if (fp == NULL) fatal(1, "\nCould not read %s.\n", inputName[which]);
+  return fp;
+}
+
 /**************************************************************************/
 void initialization() {
 
@@ -235,10 +1043,45 @@ void initialization() {
   nInst = 0;
   nShift = -1;
   nPri = -1;  
-
+  memset(&con, 0, sizeof(con));  /* prepareConsecutive leaves slots of an
+                                    earlier call in place, so start every
+                                    seed as the first one does */
+  memset(seedCount, 0, sizeof(seedCount));
   return;
 }
 
+/*************************************************************************/
+/* Random numbers.  rand keeps one state for the whole process, so each 
+   thread has a generator of its own instead.  It is the additive feedback
+   generator of the C library (TYPE_3, as srand and rand), so a seed gives
+   the same priorities as it always has. */
+
+_Thread_local int randTable[31];
+_Thread_local int randFront = 3, randRear = 0;
+
+int nextRandom() {       // rand for this thread 
+  unsigned int value = (unsigned int)randTable[randFront] + 
+                       (unsigned int)randTable[randRear];
+  randTable[randFront] = value;
+  if (++randFront == 31) randFront = 0;
+  if (++randRear == 31) randRear = 0;
+  return value >> 1;
+}
+
+void seedRandom(unsigned int s) {  // srand for this thread 
+  randTable[0] = s ? s : 1;
+  for (int i = 1; i < 31; i++) {   // 16807*r mod 2^31 - 1 without overflow 
+    long hi = randTable[i - 1]/127773;
+    long lo = randTable[i - 1]%127773;
+    long word = 16807*lo - 2836*hi;
+    if (word < 0) word += 2147483647;
+    randTable[i] = word;
+  }
+  randFront = 3;
+  randRear = 0;
+  for (int i = 0; i < 310; i++) nextRandom();
+}
+
 /*************************************************************************/
 float randP() {          /* random number generator returns a number between 0
                            and 0.1.  It looks more complex than it needs to 
@@ -246,8 +1089,75 @@ float randP() {          /* random number generator returns a number between 0
                            not good.  It is not flat, but it does not have to
                            be for this application. */
 
-  return ((rand() & 1000)/10000.0)*((rand() & 1000)/1000.0)*
-                                   ((rand() & 1000)/1000.0);
+  return ((nextRandom() & 1000)/10000.0)*((nextRandom() & 1000)/1000.0)*
+                         ((nextRandom() & 1000)/1000.0)*tuning[TN_RAND];
+}
+
+/*************************************************************************/
+/* Fixed point.  With --priorities=fixed the priorities are integers in 
+   units of 1/FIX_ONE: the base and virgin priorities, which are only ever
+   set, are converted where they are summed; the bonus is kept in fixed 
+   point beside the float one; the random priority is the product of the
+   same three draws as randP, in integers.  The total of each shifter and
+   its index are packed in a 64-bit key in priKey, the total with its 
+   sign bit flipped in the high word, so that unsigned order is the order
+   of the totals, and the complement of the index in the low word, so 
+   that a tie goes to the first shifter as with the floats.  prepareShifts
+   then takes the largest key.  Nothing is rounded by the machine, so the
+   results are the same with any compiler or instruction set; they can 
+   differ from those with floats where a float sum rounds to a tie or 
+   past another.  The float fields follow, for the log. */
+
+#define FIX_ONE (1 << 20)
+
+int toFixed(double x) {
+  return (int)(x*FIX_ONE + (x < 0 ? -0.5 : 0.5));
+}
+
+/*************************************************************************/
+void drawRandPri(int ii) {  // randPri, in fixed point if so 
+  if (! fixedPri) {
+    ind[ii].randPri = randP();
+    return;
+  }
+  long long a = nextRandom() & 1000;  // as randP: a/10^4 * b/10^3 * c/10^3
+  long long b = nextRandom() & 1000;
+  long long c = nextRandom() & 1000;
+  ind[ii].fixRand = (int)(a*b*c*toFixed(tuning[TN_RAND])/10000000000LL);
+  ind[ii].randPri = (float)ind[ii].fixRand/FIX_ONE;
+}
+
+/*************************************************************************/
+void sumPri(int ii) {       // totPri, and with fixed point the key 
+  struct individual *d = &ind[ii];
+  if (! fixedPri) {
+    d->totPri = d->basePri + d->virginPri + d->bonusPri + d->randPri;
+    return;
+  }
+  int total = toFixed(d->basePri) + toFixed(d->virginPri) + d->fixBonus + 
+    d->fixRand;
+  d->totPri = (float)total/FIX_ONE;
+  priKey[ii] = (unsigned long long)((unsigned int)total ^ 0x80000000u) << 32
+    | (unsigned int)~ii;
+}
+
+/*************************************************************************/
+void keepBonus(int ii) {    // the bonus of the shifter who got the shift 
+  ind[ii].bonusPri *= tuning[TN_BONUS_KEPT];
+  ind[ii].fixBonus = (int)((long long)ind[ii].fixBonus*
+                           toFixed(tuning[TN_BONUS_KEPT])/FIX_ONE);
+}
+
+/*************************************************************************/
+void addBonus(int ii) {     // the bonus of the others who asked for it 
+  ind[ii].bonusPri += tuning[TN_BONUS_OTHERS];
+  ind[ii].fixBonus += toFixed(tuning[TN_BONUS_OTHERS]);
+}
+
+/*************************************************************************/
+void clearBonus(int ii) {
+  ind[ii].bonusPri = 0.0;
+  ind[ii].fixBonus = 0;
 }
 
 
@@ -286,7 +1196,8 @@ void clearBuffer(int n) {  /* This routine should not be necessary, but
 }    
 
 /**************************************************************************/
-void parsePriFile() {
+void readPriorities(FILE *fp, char *fileName, struct priority *table, 
+                    int *nTable) {
 
   /* This routine uses a specially prepared .csv file which has only two      
    fields, the shifter's ECLID and the assigned priority code. 
@@ -296,8 +1207,8 @@ void parsePriFile() {
   int bytesRead = 0;
   int c;
 
-  FILE *fp;
-  fp = fopen("Pri.csv","r");
+  if (fp == NULL) fatal(1, "\nCould not open the priority file %s.\n", 
+                        fileName);
 
   // Read in the data one line at a time  
 
@@ -308,29 +1219,52 @@ void parsePriFile() {
     // I'm not sure why, but the () in the above for command are necessary
     bytesRead++;                // make room for the final comma 
     buffer[bytesRead] = ',';    // insert final comma 
-    nPri++;
+    int n = ++*nTable;
 
     // Start filling the priorites struct. ECLID first
 
     bIndex = -1;     // This is the location of the virtual preceeding comma 
     readBuffer(STRING);
-    strcpy (pri[nPri].ECLID, sValue);
+    strcpy (table[n].ECLID, sValue);
     readBuffer (STRING);
     switch (sValue[0]) {
-    case 'N' : pri[nPri].basePri = N; break;
-    case 'L' : pri[nPri].basePri = L; break;
-    case 'M' : pri[nPri].basePri = M; break;
-    case 'H' : pri[nPri].basePri = H; break;
-    case 'X' : pri[nPri].basePri = X; break;
-    default  : printf ("\nPriority code %s not recognized for %s.\n",
-		       sValue[0], pri[nPri].ECLID);
-      exit(1);
+    case 'N' : table[n].basePri = N; break;
+    case 'L' : table[n].basePri = L; break;
+    case 'M' : table[n].basePri = M; break;
+    case 'H' : table[n].basePri = H; break;
+    case 'X' : table[n].basePri = X; break;
+    default  : fatal(1, "\nPriority code %c not recognized for %s in %s.\n",
+		     sValue[0], table[n].ECLID, fileName);
     }
     if (c == EOF) break;
   }
   fclose(fp);
   return;
 }
+
+/**************************************************************************/
+void parsePriFile() {    // input priority file 
+  readPriorities(openInput(PRI_FILE), "Pri.csv", pri, &nPri);
+}
+
+/**************************************************************************/
+bool findPriority(int ii) {  /* sets the base priority of shifter ii from
+                                Pri.csv or from the resolved priorities;
+                                returns false if it is in neither */
+  for (int ie = 0; ie <= nPri; ie++) { 
+    if (strcmp(ind[ii].ECLID, pri[ie].ECLID) == 0) {
+      ind[ii].basePri = pri[ie].basePri;
+      return true;
+    }
+  }
+  for (int ie = 0; ie <= nResolved; ie++) {
+    if (strcmp(ind[ii].ECLID, resolved[ie].ECLID) == 0) {
+      ind[ii].basePri = resolved[ie].basePri;
+      return true;
+    }
+  }
+  return false;
+}
   
 
 /*************************************************************************/
@@ -348,7 +1282,7 @@ The institution number is the index. */
   int c;
 
   FILE *fp;
-  fp = fopen("Inst.csv","r");
+  fp = openInput(INST_FILE);
 
   // Read in the questionnaire data one line at a time  
 
@@ -393,7 +1327,7 @@ the shift date in ECL input form.  The shift number begins with zero. */
   int c;
 
   FILE *fp;
-  fp = fopen("Shift.csv","r");
+  fp = openInput(SHIFT_FILE);
 
   // Read in the data one line at a time  
 
@@ -418,6 +1352,9 @@ the shift date in ECL input form.  The shift number begins with zero. */
     /* Now the two integer fields */
 
     readBuffer (INTEGER);
+    if (iValue < 0 || iValue >= pattern->types) 
+      fatal(1, "\nShift %d has type %d, not one of the %s pattern.\n", 
+            nShift, iValue, pattern->name);
     shift[nShift].stype = iValue;
     readBuffer (INTEGER);
     shift[nShift].points = iValue;
@@ -435,78 +1372,48 @@ the shift date in ECL input form.  The shift number begins with zero. */
     if (c == EOF) break; 
   }
   fclose(fp);
-  if (totShifts != NSHIFTS) {
-    printf("totShifts = %d != NSHIFTS, exitiing\n",totShifts);
-    exit(0);
-  }
+  if (totShifts != NSHIFTS) 
+    fatal(0, "totShifts = %d != NSHIFTS, exitiing\n",totShifts);
 
 }
 
 /*************************************************************************/
 void dumpIndividual(int ii) { /* dumps the individual struct for debugging */
 
-    printf("name = %s\n",ind[ii].name);
-    printf("ECLID = %s\n",ind[ii].ECLID);
-    printf("email = %s\n",ind[ii].email);
-    printf("home = %d\n",ind[ii].home);
-    printf("homeName = %s\n",ind[ii].homeName);
-    printf("request = %d\n",ind[ii].request);
-    printf("over = %d\n",ind[ii].over);
-    printf("consec = %d\n",ind[ii].consec);
-    printf("rest = %d\n",ind[ii].rest);
-    printf("strict = %d\n",ind[ii].strict);
-    printf("nonConsec = %d\n",ind[ii].nonConsec);
-    printf("basePri = %f\n",ind[ii].basePri);
-    printf("virginPri = %f\n",ind[ii].virginPri);
-    printf("bonusPri = %f\n",ind[ii].bonusPri);
-    printf("randPri = %f\n",ind[ii].randPri);
-    printf("totPri = %f\n",ind[ii].totPri);
-    printf("nPAssigned = %d\n", ind[ii].nPAssigned);
-    printf("nSAssigned = %d\n", ind[ii].nSAssigned);
-    printf("open = %d\n", ind[ii].open);
-
-    fprintf(fl,"name = %s\n",ind[ii].name);
-    fprintf(fl,"ECLID = %s\n",ind[ii].ECLID);
-    fprintf(fl,"email = %s\n",ind[ii].email);
-    fprintf(fl,"home = %d\n",ind[ii].home);
-    fprintf(fl,"homeName = %s\n",ind[ii].homeName);
-    fprintf(fl,"request = %d\n",ind[ii].request);
-    fprintf(fl,"over = %d\n",ind[ii].over);
-    fprintf(fl,"consec = %d\n",ind[ii].consec);
-    fprintf(fl,"rest = %d\n",ind[ii].rest);
-    fprintf(fl,"strict = %d\n",ind[ii].strict);
-    fprintf(fl,"nonConsec = %d\n",ind[ii].nonConsec);
-    fprintf(fl,"basePri = %f\n",ind[ii].basePri);
-    fprintf(fl,"virginPri = %f\n",ind[ii].virginPri);
-    fprintf(fl,"bonusPri = %f\n",ind[ii].bonusPri);
-    fprintf(fl,"randPri = %f\n",ind[ii].randPri);
-    fprintf(fl,"totPri = %f\n",ind[ii].totPri);
-    fprintf(fl,"nPAssigned = %d\n", ind[ii].nPAssigned);
-    fprintf(fl,"nSAssigned = %d\n", ind[ii].nSAssigned);
-    fprintf(fl,"open = %d\n", ind[ii].open);
+    tee(fl,"name = %s\n",ind[ii].name);
+    tee(fl,"ECLID = %s\n",ind[ii].ECLID);
+    tee(fl,"email = %s\n",ind[ii].email);
+    tee(fl,"home = %d\n",ind[ii].home);
+    tee(fl,"homeName = %s\n",ind[ii].homeName);
+    tee(fl,"request = %d\n",ind[ii].request);
+    tee(fl,"over = %d\n",ind[ii].over);
+    tee(fl,"consec = %d\n",ind[ii].consec);
+    tee(fl,"rest = %d\n",ind[ii].rest);
+    tee(fl,"strict = %d\n",ind[ii].strict);
+    tee(fl,"nonConsec = %d\n",ind[ii].nonConsec);
+    tee(fl,"basePri = %f\n",ind[ii].basePri);
+    tee(fl,"virginPri = %f\n",ind[ii].virginPri);
+    tee(fl,"bonusPri = %f\n",ind[ii].bonusPri);
+    tee(fl,"randPri = %f\n",ind[ii].randPri);
+    tee(fl,"totPri = %f\n",ind[ii].totPri);
+    tee(fl,"nPAssigned = %d\n", ind[ii].nPAssigned);
+    tee(fl,"nSAssigned = %d\n", ind[ii].nSAssigned);
+    tee(fl,"open = %d\n", ind[ii].open);
 
 }
 /*************************************************************************/
 void dumpInstitution(int ii) { /* dumps the institution struct for debugging */
 
-  printf("name = %s\n", inst[ii].name);
-  printf("quota = %d\n", inst[ii].quota);
-
-  fprintf(fl,"name = %s\n",inst[ii].name);
-  fprintf(fl,"quota = %d\n", inst[ii].quota);
+  tee(fl,"name = %s\n",inst[ii].name);
+  tee(fl,"quota = %d\n", inst[ii].quota);
 }
 /*************************************************************************/
 void dumpShift(int ii) { /* dumps the shift struct for debugging */
 
-  printf("date = %s\n",shift[ii].date);
-  printf("type = %s\n",shift[ii].type);
-  printf("stype = %d\n",shift[ii].stype);
-  printf("points = %d\n",shift[ii].points);
-
-  fprintf(fl,"date = %s\n",shift[ii].date);
-  fprintf(fl,"type = %s\n",shift[ii].type);
-  fprintf(fl,"stype = %d\n",shift[ii].stype);
-  fprintf(fl,"points = %d\n",shift[ii].points);
+  tee(fl,"date = %s\n",shift[ii].date);
+  tee(fl,"type = %s\n",shift[ii].type);
+  tee(fl,"stype = %d\n",shift[ii].stype);
+  tee(fl,"points = %d\n",shift[ii].points);
 }
 
 /*************************************************************************/
@@ -521,12 +1428,11 @@ void parseIndFile() {
   int c;
 
   FILE *fp;
-  fp = fopen("Ind.csv","r");
-  if (fp == NULL) printf("Null pointer retruned\n");
+  fp = openInput(IND_FILE);
 
   if (verbose) {
-    printf("\nShifter List:\n");
-    fprintf(fl, "\nShifter List:");
+    tee(NULL, "\nShifter List:\n");
+    put(fl, "\nShifter List:");
   }
 
   // Read in the questionnaire data one line at a time  
@@ -559,6 +1465,9 @@ void parseIndFile() {
     readBuffer(INTEGER);
     ind[nInd].home = iValue;           // Q5 institution  
     int home = iValue;     // save for later index  
+    if (home < 1 || home > nInst) 
+      fatal(1, "\nShifter %s is from institution %d, which is not in "
+            "Inst.csv.\n", ind[nInd].name, home);
     strcpy(ind[nInd].homeName, inst[iValue].name); // put in the short name  
     readBuffer(INTEGER);
     ind[nInd].request = iValue;        // Q6 requested number of points
@@ -591,8 +1500,9 @@ void parseIndFile() {
     readBuffer(INTEGER);             // No answer does not matter  
     ind[nInd].nonConsec = (nonConsec == 2) ? 1 : iValue + 1;
     readBuffer(INTEGER);             // Q14 extra virginity request.  
-    ind[nInd].virginPri = VIRGIN;
-    if (nChar != 0 && iValue == YES) ind[nInd].virginPri += EXTRA_V; 
+    ind[nInd].extraVirgin = nChar != 0 && iValue == YES;
+    ind[nInd].virginPri = tuning[TN_VIRGIN];
+    if (ind[nInd].extraVirgin) ind[nInd].virginPri += tuning[TN_EXTRA_V]; 
     readBuffer(INTEGER);             // Q15 request for priority  
     ind[nInd].special = (nChar == 0) ? NO : iValue;
     readBuffer(STRING);              
@@ -628,26 +1538,14 @@ void parseIndFile() {
 
     // Set the priorities */
  
-    bool foundIt = true;
     if (ind[nInd].special == NO) ind[nInd].basePri = 1.0;
-    else {                                // search for assigned priority */
-      foundIt = false;
-      for (int ie = 0; ie <= nPri; ie++) { 
-        if (strcmp(ind[nInd].ECLID, pri[ie].ECLID) == 0) {
-          ind[nInd].basePri = pri[ie].basePri;
-          foundIt = true;
-          break;
-        }
-      }
-    } 
-    if (! foundIt) {                    // ask for it */
-      printf("\nPriority not found for %s (%s).\n",
-             ind[nInd].name, ind[nInd].ECLID);
-      printf("Justification: %s\n", ind[nInd].just);
-      printf("Please enter the priority.\n");
-      float basePri;
-      scanf("%f", &basePri);
-      ind[nInd].basePri = basePri;   
+    else if (! findPriority(nInd)) {    /* resolvePriorities has already
+                                           settled every missing one */
+      if (! resolving) 
+        fatal(1, "\nPriority not found for %s (%s).\n",
+              ind[nInd].name, ind[nInd].ECLID);
+      missing[nMissing++] = nInd;       // resolvePriorities deals with it 
+      ind[nInd].basePri = 0.0;
     }
 
     // zero base priorities for institutions with zero quota */
@@ -662,10 +1560,9 @@ void parseIndFile() {
 
     // set priorities */
      
-    ind[nInd].bonusPri = 0.0;
-    ind[nInd].randPri = randP();
-    ind[nInd].totPri = ind[nInd].basePri + ind[nInd].virginPri 
-      + ind[nInd].bonusPri + ind[nInd].randPri;
+    clearBonus(nInd);
+    drawRandPri(nInd);
+    sumPri(nInd);
 
     // Optional print for debugging */
 
@@ -673,41 +1570,32 @@ void parseIndFile() {
 
     // Basic output -- also goes to the log*/
 
-    char str[80];
     if (verbose) { 
-      printf("\n\nShifter %d, %s (%s) from %s has requested %d point(s).\n",
-	     nInd,ind[nInd].name, ind[nInd].ECLID, ind[nInd].homeName,
-	ind[nInd].request);
-      fprintf(fl,"\n\nShifter %d, %s (%s) from %s has requested %d point(s).\n"
-	      ,nInd,ind[nInd].name, ind[nInd].ECLID, ind[nInd].homeName,
-	ind[nInd].request);
-      printf("(S)he has base priority %4.1f\n", ind[nInd].basePri);
-      fprintf(fl,"(S)he has base priority %4.1f\n", ind[nInd].basePri);
+      tee(fl,"\n\nShifter %d, %s (%s) from %s has requested %d point(s).\n",
+	  nInd,ind[nInd].name, ind[nInd].ECLID, ind[nInd].homeName,
+	  ind[nInd].request);
+      tee(fl,"(S)he has base priority %4.1f\n", ind[nInd].basePri);
 
       // LoP-1 requests */
 
-      printf("The request for LoP-1 was\n");
-      fprintf(fl,"The request for LoP-1 was\n");
+      tee(fl,"The request for LoP-1 was\n");
       int nsh = 1;            // count requested shifts for formating */
       for (int nr = 0; nr < NSHIFTS; nr++) {
 	if (ind[nInd].lop1[nr]) {
-          printf("%-7s%-8s", shift[nr].date, shift[nr].type);
-	  fprintf(fl,"%-7s%-8s", shift[nr].date, shift[nr].type);
-          if (nsh++ % 5 == 0) {printf("\n"); fprintf(fl,"\n");}
+          tee(fl,"%-7s%-8s", shift[nr].date, shift[nr].type);
+          if (nsh++ % 5 == 0) tee(fl,"\n");
         }
       }
 
       // LoP-2 requests */
       
-      if (nsh % 5 != 1) {printf("\n"); fprintf(fl,"\n");}      
-      printf("The request for LoP-2 was\n");
-      fprintf(fl,"The request for LoP-2 was\n");
+      if (nsh % 5 != 1) tee(fl,"\n");
+      tee(fl,"The request for LoP-2 was\n");
       nsh = 1;            // count requested shifts for formating */
       for (int nr = 0; nr < NSHIFTS; nr++) {
 	if (ind[nInd].lop2[nr]) {
-	  printf("%-7s%-8s", shift[nr].date, shift[nr].type);
-	  fprintf(fl,"%-7s%-8s", shift[nr].date, shift[nr].type);
-	  if (nsh++ % 5 == 0) {printf("\n"); fprintf(fl,"\n");}
+	  tee(fl,"%-7s%-8s", shift[nr].date, shift[nr].type);
+	  if (nsh++ % 5 == 0) tee(fl,"\n");
         }
       } 
     }
@@ -715,19 +1603,18 @@ void parseIndFile() {
   }
   nInd++;  // Note there are nInd shifters with the index [0,...,nInd-1] */
   if (verbose) {
-    printf("\nThere are a total of %d shifters requesting a total of %d points.\n"
-	   ,nInd, totRequests);
-    printf("There are %d total shift points available this period.\n", totPoints);
-    fprintf(fl, "\nThere are a total of %d shifters requesting a total of %d points.\n" , nInd, totRequests);
-    fprintf(fl, "There are %d total shift points available this period.\n"
-            , totPoints);
+    tee(fl, "\nThere are a total of %d shifters requesting a total of %d points.\n",
+        nInd, totRequests);
+    tee(fl, "There are %d total shift points available this period.\n",
+        totPoints);
   }
   fclose(fp);
 } 
 
 /*************************************************************************/
-bool qualified(int ii, int is){    /* determines whether a shifter is 
-                                      qualified */
+static inline __attribute__((always_inline)) 
+bool qualifiedBy(const struct rules *r, int ii, int is) {  /* qualified 
+                                                      under the rule set r */
 /*
     The requirements for a qualified shifter are
 (1) the shifter requested the shift                                      
@@ -742,41 +1629,62 @@ bool qualified(int ii, int is){    /* determines whether a shifter is
         = 3 > 9 shifts; = 4, > 15 shifts;               
                     
     The consecutive shift requirement must also be met, if requested,
-    but that will be dealt with later */
+    but that will be dealt with later; (1) is checked by qualified, where
+    the compiler can inline it into the loops of the callers */
 
-      if (! ind[ii].active[is]) return false;  // no request 
   int togo = ind[ii].request - ind[ii].nPAssigned;
   if (togo <= 0) return false;                 // shifter is closed 
-  if (togo - shift[is].points < 0 && ind[ii].over == NO_OVERAGE) return false;
-  if (ind[ii].basePri <= 0.0 && lop1) return false;
+  if (r->overage && togo - shift[is].points < 0 && 
+      ind[ii].over == NO_OVERAGE) return false;
+  if (r->zeroBaseWaits && ind[ii].basePri <= 0.0 && lop1) return false;
 //  if (ind[ii].caution && shift[is].points > 1 && lop1) return false;
                                         // isa is the index of assigned shift 
-  if (ind[ii].caution && shift[is].points > 10 && lop1) return false;
+  if (r->caution && ind[ii].caution && shift[is].points > cautionShort(r)
+      && lop1) return false;
   for (int isa = 0; isa < ind[ii].nSAssigned; isa++) {
     int adif = abs(is - ind[ii].assigned[isa]);  // absolute distance 
-    if (adif < 3) return false;
-    if (ind[ii].nonConsec == 2 && adif < 6) return false;
-    if (ind[ii].nonConsec == 3 && adif < 9) return false;
-    if (ind[ii].nonConsec == 4 && adif < 15) return false;
+    if (adif < dayGap[0]) return false;
+    if (ind[ii].nonConsec == 2 && adif < dayGap[1]) return false;
+    if (ind[ii].nonConsec == 3 && adif < dayGap[2]) return false;
+    if (ind[ii].nonConsec == 4 && adif < dayGap[3]) return false;
   }
   return true;                 // all tests passed 
 }
 
+/*************************************************************************/
+bool qualified(int ii, int is){    /* determines whether a shifter is 
+                                      qualified (see rules) */
+  tally(CT_QUALIFIED);
+  if (! ind[ii].active[is]) return false;  // no request 
+  if (rules == &icarusRules) return qualifiedBy(&icarusRules, ii, is);
+  if (rules == &novaRules) return qualifiedBy(&novaRules, ii, is);
+  return qualifiedBy(rules, ii, is);  // generic 
+}
+
 /*************************************************************************/
 void killInst(int iInst, float diff) {   /* set priorities to diff for iInst
                                          due to fulfillment of quota */
+  trace(EV_KILL, 0, 0, iInst, 0, diff);
   for (int i = 0; i < nInd; i++) {
     if (ind[i].home == iInst) {
       ind[i].basePri = diff;       /* totals will be calculated before
                                      next shift assignment */
-      ind[i].bonusPri = 0.0;
+      clearBonus(i);
     }
   }
 }
 
+/*************************************************************************/
+bool cautioned(int iInst, float diff) {  /* whether an institution diff 
+                                            points short is cautioned */
+  double c = cautionShort(rules);
+  return diff == c && inst[iInst].quota > c;
+}
+
 /*************************************************************************/
 void cautionInst(int iInst) {      /* set caution flag if quota is just  
 				        one point short */
+  trace(EV_CAUTION, 0, 0, iInst, 0, 0.0);
   for (int i = 0; i < nInd; i++) {
     if (ind[i].home == iInst) ind[i].caution = true;              
   }
@@ -787,16 +1695,16 @@ void dumpPreparedShifts() { // number controled by global nDumpShift */
   if (! tDumpShift) return;
   tDumpShift--;
   for (int is = 0; is < nDumpShift; is++) {
-    printf("\nDump of prepared struct shifts %d %s %s\n",
-           is, shift[is].date, shift[is].type);
-    printf("open = %d\n", shift[is].open);
-    printf("points = %d\n", shift[is].points);
+    tee(NULL, "\nDump of prepared struct shifts %d %s %s\n",
+        is, shift[is].date, shift[is].type);
+    tee(NULL, "open = %d\n", shift[is].open);
+    tee(NULL, "points = %d\n", shift[is].points);
     int nr = shift[is].nRequests;
-    printf("nRequests = %d\n", nr);
+    tee(NULL, "nRequests = %d\n", nr);
     for (int ir = 0; ir < nr; ir++) 
-      printf("requester %d  = %d\n", ir, shift[is].requesters[ir]);
-    printf("topRequester = %d\n", shift[is].topRequester);
-    printf("assigned = %d\n", shift[is].assigned);
+      tee(NULL, "requester %d  = %d\n", ir, shift[is].requesters[ir]);
+    tee(NULL, "topRequester = %d\n", shift[is].topRequester);
+    tee(NULL, "assigned = %d\n", shift[is].assigned);
   }
 }
   
@@ -807,26 +1715,93 @@ void prepareShifts() {       // collects shift data
      The requirements for a valid shifter are listed in the 
      qualified function.  */
 
+  phaseStart(PH_PREPARE);
   for (int is = 0; is < NSHIFTS; is++) {        // cycle thru all shifts 
     if (! shift[is].open) continue;        
     shift[is].nRequests = 0;
     float topPriority = -99.;
+    unsigned long long topKey =                // the same in fixed point 
+      (unsigned long long)((unsigned int)toFixed(-99.) ^ 0x80000000u) << 32
+      | 0xffffffffu;
     int nCand = 0;                             // number of candidates 
-    for (int ii = 0; ii < nInd; ii++) {         // cycle thru all shifters 
+    const int *list = lop1 ? asked1[is] : asked[is];
+    int nTry = (engine == FAST) ? (lop1 ? nAsked1[is] : nAsked[is]) : nInd;
+    for (int it = 0; it < nTry; it++) {         // cycle thru all shifters 
+      int ii = (engine == FAST) ? list[it] : it;
       if (qualified(ii, is)) {
         nCand++;
         shift[is].nRequests++;
 	shift[is].requesters[nCand - 1] = ii;
-        if (ind[ii].totPri > topPriority) {
+        if (fixedPri) {
+          if (priKey[ii] > topKey) {
+            topKey = priKey[ii];
+            shift[is].topRequester = ii;
+          }
+        }
+        else if (ind[ii].totPri > topPriority) {
           topPriority = ind[ii].totPri;
           shift[is].topRequester = ii;
         }    
       }
     }  
   }     
+  phaseStop(PH_PREPARE);
   dumpPreparedShifts();  // controled by global dumpShift parameter 
 } 
 
+/*************************************************************************/
+void listCandidates(const struct individual *d, int n, 
+                    const struct shifts *sh, int *nA, int (*a)[MAXIND], 
+                    int *nA1, int (*a1)[MAXIND]) {  /* the presolve of the
+                                                       fast engine */
+  for (int is = 0; is < NSHIFTS; is++) {
+    nA[is] = nA1[is] = 0;
+    for (int ii = 0; ii < n; ii++) {      // the same range as prepareShifts
+      if (d[ii].request <= 0 || (rules->overage && 
+          d[ii].request < sh[is].points && d[ii].over == NO_OVERAGE)) 
+        continue;
+      if (d[ii].lop2[is]) a[is][nA[is]++] = ii;
+      if (d[ii].lop1[is] && (d[ii].basePri > 0.0 || ! rules->zeroBaseWaits))
+        a1[is][nA1[is]++] = ii;
+    }
+  }
+}
+
+/*************************************************************************/
+void listPartners(const struct shifts *sh, struct neighbors *nb) {  /* the
+                                     consecutive tables of the fast engine */
+  for (int is = 0; is < NSHIFTS; is++) {
+    int type = sh[is].stype;
+    for (int r = 0; r < 2; r++) {
+      nb->partners[is][r].n = pattern->nCand[type][r];
+      for (int iCand = 0; iCand < pattern->nCand[type][r]; iCand++) {
+        int cand = is + pattern->distance[type][iCand];
+        nb->partners[is][r].shift[iCand] = 
+          cand < 0 || cand >= NSHIFTS ? -1 : cand;
+      }
+    }
+  }
+  int n = 0;
+  for (int is = 0; is < NSHIFTS; is++) nb->tradeEnd[is] = -1;
+  for (int is = 0; is < NSHIFTS; is++) {
+    if (nb->tradeEnd[is] >= 0) continue;     // in the class of another 
+    int first = n;
+    for (int js = is; js < NSHIFTS; js++) 
+      if (sh[js].stype == sh[is].stype && sh[js].points == sh[is].points)
+        nb->tradeList[n++] = js;
+    for (int k = first; k < n; k++) {
+      nb->tradeFirst[nb->tradeList[k]] = first;
+      nb->tradeEnd[nb->tradeList[k]] = n;
+    }
+  }
+}
+
+/*************************************************************************/
+void listRequests() {        // fills the lists of the fast engine 
+  listCandidates(ind, nInd, shift, nAsked, asked, nAsked1, asked1);
+  listPartners(shift, &neighbors);
+}
+
 /*************************************************************************/
 bool findNextShift() {  // returns false if no more shifts; sets nextShift 
   
@@ -835,6 +1810,7 @@ bool findNextShift() {  // returns false if no more shifts; sets nextShift
 
   int minRequests = 999;
 
+  phaseStart(PH_NEXT);
   for (int is = 0; is < NSHIFTS; is++) {     // cycle thru all shifts 
     if (! shift[is].open || shift[is].nRequests == 0)  continue;  
     if (shift[is].nRequests < minRequests) { // looking for min requests    
@@ -842,6 +1818,7 @@ bool findNextShift() {  // returns false if no more shifts; sets nextShift
       nextShift= is;
     }
   }
+  phaseStop(PH_NEXT);
   return (minRequests == 999) ? false : true; // done with this LoP 
 }
 
@@ -851,13 +1828,13 @@ void prepareConsecutive() {  // fills the consecutive struct
 
   int ii = shift[nextShift].topRequester;  // indentify requester  
   int type = shift[nextShift].stype;       // indentify type of shift  
-  int nCand = 4;                           // default number to search  
-  if (ind[ii].rest == SHORT_REST) nCand = 5;  // 8 hours rest enough  
-  if (ind[ii].rest == SHORT_REST && type == day) nCand = 6; 
-                                           // day gets another  
+  int rest = ind[ii].rest == SHORT_REST;   // 8 hours rest enough  
+  int nCand = pattern->nCand[type][rest];  // number to search 
+  const int *partner = neighbors.partners[nextShift][rest].shift;
   con.nCand = nCand;                       // fill the struct value  
   for (int iCand = 0; iCand < nCand; iCand++) { // loop over shift candidates  
-    int cand = nextShift + conIndex[type][iCand]; // candidate shift  
+    int cand = (engine == FAST) ? partner[iCand]       // candidate shift  
+                                : nextShift + pattern->distance[type][iCand];
     if (cand < 0 || cand >= NSHIFTS) continue;    // shift must be in bounds
 
     // check if this is an multipoint shift for which there are insufficint
@@ -887,8 +1864,10 @@ void prepareConsecutive() {  // fills the consecutive struct
 
       if (ind[iOcc].consec == YES) continue;  // see above        
       int minRequests = 999;              // minimium number of requests found
-      int iTrade = 0;                       // needs to be outside for scope   
-      for (; iTrade < NSHIFTS; iTrade++) {  // cycle thru shifts  
+      int first = (engine == FAST) ? neighbors.tradeFirst[cand] : 0;
+      int end = (engine == FAST) ? neighbors.tradeEnd[cand] : NSHIFTS;
+      for (int it = first; it < end; it++) {  // cycle thru shifts  
+        int iTrade = (engine == FAST) ? neighbors.tradeList[it] : it;
         if (! shift[iTrade].open || ! ind[iOcc].active[iTrade] || 
 	    shift[iTrade].stype != shift[cand].stype ||
 	    shift[iTrade].points != shift[cand].points || iTrade == nextShift) 
@@ -899,7 +1878,7 @@ void prepareConsecutive() {  // fills the consecutive struct
         bool testFail = false;
         for (int iTest = 0; iTest < ind[iOcc].nSAssigned; iTest++) {
           int testShift = ind[iOcc].assigned[iTest];
-          if (abs(testShift - iTrade) < 3) { testFail = true; break;}
+          if (abs(testShift - iTrade) < dayGap[0]) {testFail = true; break;}
         }
         if (testFail) continue;                // There is a conflict  
 
@@ -958,42 +1937,36 @@ void assignShift(int callType) {   // assigns shift and cleans up
 
   int thisShift;      // general variable for the shift to be assigned 
   int thisInd;        // shifter to whom the shift is being assigned   
+  phaseStart(PH_ASSIGN);
+  tally(callType == 2 ? CT_TRADE : CT_ASSIGN);
   switch (callType) { // set up each type of call 
   case 0 : thisShift = nextShift;
            thisInd = shift[nextShift].topRequester;
            break;
   case 1 : thisShift = con.conShift;
            thisInd = shift[nextShift].topRequester;
-           if (verbose && con.decision == 1) {
-             printf ("An open shift was available:\n");
-	     fprintf (fl,"An open shift was available:\n");
-           }
-           if (verbose && con.decision == 2) {
-             printf ("\nThis is a shift made available by a trade:");
-             fprintf (fl,"\nThis is a shift made available by a trade:");
-           }
+           if (verbose && con.decision == 1) 
+             tee (fl,"An open shift was available:\n");
+           if (verbose && con.decision == 2) 
+             tee (fl,"\nThis is a shift made available by a trade:");
            break;
   case 2 : thisShift = con.tradeShift;
     int thatShift = con.conShift; // the starting shift of the trade 
            thisInd = shift[thatShift].assigned; 
-           if (verbose) {
-	     printf ("A trade shift was available:\n");
-             fprintf (fl,"A trade shift was available:\n");
-	   }
+           if (verbose) tee (fl,"A trade shift was available:\n");
   }
 
   // log shift assignment; first the initial conditions 
    
+  trace(callType == 2 ? EV_TRADE : EV_ASSIGN, 
+        callType + (callType == 1 ? 16*con.decision : 0), thisShift, thisInd, shift[thisShift].nRequests, ind[thisInd].totPri);
   if (verbose) {
     int nRequests = shift[thisShift].nRequests;
-    printf("\nShift %d %s %s: %d qualified requester(s):\n", thisShift,
-         shift[thisShift].date, shift[thisShift].type, nRequests);
-    fprintf(fl,"\nShift %d %s %s: %d qualified requester(s):\n", thisShift,
-         shift[thisShift].date, shift[thisShift].type, nRequests);
+    tee(fl,"\nShift %d %s %s: %d qualified requester(s):\n", thisShift,
+        shift[thisShift].date, shift[thisShift].type, nRequests);
     for (int ir = 0; ir < nRequests; ir++) {
       int nr = shift[thisShift].requesters[ir];   // get requester number 
-      printf("%s with priority %5.3f\n", ind[nr].name , ind[nr].totPri);
-      fprintf(fl,"%s with priority %5.3f\n", ind[nr].name , ind[nr].totPri);
+      tee(fl,"%s with priority %5.3f\n", ind[nr].name , ind[nr].totPri);
     }
   } 
 
@@ -1012,7 +1985,7 @@ void assignShift(int callType) {   // assigns shift and cleans up
     float diff = inst[iInst].quota - inst[iInst].nPAssigned;
     if (diff <= 0) killInst(iInst, diff);
 //    if (diff == 1 && inst[iInst].quota > 1) cautionInst(iInst);
-    if (diff == 10 && inst[iInst].quota > 10) cautionInst(iInst);
+    if (cautioned(iInst, diff)) cautionInst(iInst);
 
     // clean up struct individual 
 
@@ -1036,30 +2009,25 @@ void assignShift(int callType) {   // assigns shift and cleans up
   for (int ireq = 0; ireq < nreq; ireq++) {	 
     int iInd = shift[thisShift].requesters[ireq];
     if (iInd == thisInd && callType < 2) {
-      ind[iInd].bonusPri *= 0.5;      // give someone else a chance 
+      keepBonus(iInd);                // give someone else a chance 
       ind[iInd].virginPri = 0.0;      // not a virgin any more 
     }
-    else  ind[iInd].bonusPri += 0.1;  /* thisInd gets a bonus too for 
-                                         the inconvenience of a trade */
+    else addBonus(iInd);              /* thisInd gets a bonus too for the 
+                                         inconvenience of a trade */
     // the priorities get summed in getNewRandPri 
   }
 
     // log shift assignment; final conditions
 
   if (verbose) {
-    printf("Shift has been assigned to %s (%s) from %s.\n",
-	   ind[thisInd].name, ind[thisInd].ECLID, inst[iInst].name);
-    fprintf(fl,"Shift has been assigned to %s (%s) from %s.\n",
-	    ind[thisInd].name, ind[thisInd].ECLID, inst[iInst].name);
-    printf("%s has %d of %d requested points.\n", ind[thisInd].name,
-           ind[thisInd].nPAssigned, ind[thisInd].request);
-    fprintf(fl,"%s has %d of %d requested points.\n", ind[thisInd].name,
-	   ind[thisInd].nPAssigned, ind[thisInd].request);
-    printf("%s has %d of %d quota points.\n", inst[iInst].name,
-           inst[iInst].nPAssigned, inst[iInst].quota);
-    fprintf(fl,"%s has %d of %d quota points.\n", inst[iInst].name,
-	    inst[iInst].nPAssigned, inst[iInst].quota);
+    tee(fl,"Shift has been assigned to %s (%s) from %s.\n",
+	ind[thisInd].name, ind[thisInd].ECLID, inst[iInst].name);
+    tee(fl,"%s has %d of %d requested points.\n", ind[thisInd].name,
+        ind[thisInd].nPAssigned, ind[thisInd].request);
+    tee(fl,"%s has %d of %d quota points.\n", inst[iInst].name,
+        inst[iInst].nPAssigned, inst[iInst].quota);
   }
+  phaseStop(PH_ASSIGN);
 }
 
 /*************************************************************************/
@@ -1068,30 +2036,27 @@ int findConsecShift() { // called from algorithm after findNextShift
   int ii = shift[nextShift].topRequester;  // identify requester 
   if (ind[ii].consec == NO) return 0;      // consecutive shift not requested
    if (verbose) {
-     printf("\n%s has requested a consecutive shift in anticipation\n",
-	    ind[ii].name);
-     printf("of being assigned to shift %d: %s  %s.\n", nextShift,
-            shift[nextShift].date, shift[nextShift].type);
-     fprintf(fl,"\n%s has requested a consecutive shift in anticipation\n",
-            ind[ii].name);
-     fprintf(fl,"of being assigned to shift %d: %s %s.\n", nextShift,
-            shift[nextShift].date, shift[nextShift].type);
+     tee(fl,"\n%s has requested a consecutive shift in anticipation\n",
+         ind[ii].name);
+     tee(NULL,"of being assigned to shift %d: %s  %s.\n", nextShift,
+         shift[nextShift].date, shift[nextShift].type);
+     put(fl,"of being assigned to shift %d: %s %s.\n", nextShift,
+         shift[nextShift].date, shift[nextShift].type);
    }
    if (ind[ii].nPAssigned + shift[nextShift].points >= ind[ii].request) {
      if (verbose) {
-       printf("But this person does not sufficient requested points.\n");
-       fprintf(fl,"But this person does not sufficient requested points\n.");
+       tee(NULL,"But this person does not sufficient requested points.\n");
+       put(fl,"But this person does not sufficient requested points\n.");
      }
+     trace(EV_CONSEC, 1, nextShift, ii, 0, 0.0);
      return 1;                        // no action needed 
    }
    int iInst = ind[ii].home;
    if (inst[iInst].nPAssigned + shift[nextShift].points >= 
       inst[iInst].quota) {
-     if (verbose) {
-       printf("But %s does not sufficient quota points.\n", inst[iInst].name);
-       fprintf(fl,"But %s does not sufficient quota points.\n", 
-         inst[iInst].name);
-     }
+     if (verbose) 
+       tee(fl,"But %s does not sufficient quota points.\n", inst[iInst].name);
+     trace(EV_CONSEC, 2, nextShift, ii, 0, 0.0);
      return 2;                        // no action needed 
    }
 
@@ -1107,46 +2072,46 @@ int findConsecShift() { // called from algorithm after findNextShift
    if (con.decision == 0) {
      if (ind[ii].strict == NOT_STRICT) { // no consecutive shift, but go ahead
        if (verbose) {
-         printf("A consecutive shift could not be found, but this person will\n");
-         printf("take the shift anyway.\n");
-	 fprintf(fl,"A consecutive shift could not be found, but this person\n");
-	 fprintf(fl,"will take the shift anyway.\n");
+         tee(NULL,"A consecutive shift could not be found, but this person will\n");
+         tee(NULL,"take the shift anyway.\n");
+	 put(fl,"A consecutive shift could not be found, but this person\n");
+	 put(fl,"will take the shift anyway.\n");
        }
+       trace(EV_CONSEC, 3, nextShift, ii, 0, 0.0);
        return 3;
      }
      if (ind[ii].strict == STRICT) { // need to recycle the shift 
        if (verbose) {
-         printf("A consecutive shift could not be found; the shift\n");
-         printf("will be recycled\n");
-	 fprintf(fl,"A consecutive shift could not be found; the shift\n");
-         fprintf(fl,"will be recycled\n");
+         tee(fl,"A consecutive shift could not be found; the shift\n");
+         tee(fl,"will be recycled\n");
        }
        ind[ii].active[nextShift] = false;  // remove the request 
+       trace(EV_CONSEC, 4, nextShift, ii, 0, 0.0);
+       tally(CT_RECYCLE);
        return 4;  // This will prevent algorithm from assigning the shift 
      }
    }
+   if (con.decision != 0) trace(EV_CONSEC, 5, nextShift, ii, 0, 0.0);
    if (con.decision == 1) assignShift(1);
    if (con.decision == 2) {assignShift(2); assignShift(1);}
+   return 5;                          // go on and assign nextShift too 
 } 
 
 /*************************************************************************/
 void getNewRandPri() {
   int i = 0;
   for (int i = 0; i < nInd; i++) {
-    ind[i].randPri = randP();
-    if (ind[i].basePri <= 0.0) ind[i].bonusPri = 0.0; // but virgin stays 
-    ind[i].totPri = ind[i].basePri + + ind[i].virginPri + ind[i].bonusPri 
-      + ind[i].randPri; 
+    drawRandPri(i);
+    if (ind[i].basePri <= 0.0) clearBonus(i);  // but virgin stays 
+    sumPri(i);
   }
 }
 
 /*************************************************************************/
 void algorithm() {
 
-  if (lop1 && verbose) {
-    printf("\nAssignments at LoP1:\n");
-    fprintf(fl, "\nAssignments at LoP1:\n");
-  }
+  if (lop1) trace(EV_LOP, 1, 0, 0, 0, 0.0);
+  if (lop1 && verbose) tee(fl, "\nAssignments at LoP1:\n");
 
   while (true) {
     prepareShifts();
@@ -1164,7 +2129,10 @@ void algorithm() {
        shift could not be found and that the shift needs to be 
        recycled.   */ 
 
-    if (findConsecShift() != 4) assignShift(0); 
+    phaseStart(PH_CONSEC);
+    int consec = findConsecShift();
+    phaseStop(PH_CONSEC);
+    if (consec != 4) assignShift(0); 
     getNewRandPri();
   }   
 }
@@ -1175,71 +2143,68 @@ void switchLoP() {           // switches from LoP-1 to LoP-2
   for (int ii = 0; ii <= nInd; ii++) 
     for (int is = 0; is < NSHIFTS; is++) 
       ind[ii].active[is] = ind[ii].lop2[is];
-  if (verbose) {
-    printf("\nSwitching to LoP-2:\n");
-    fprintf(fl,"\nSwitching to LoP-2:\n");
-  }
+  trace(EV_LOP, 2, 0, 0, 0, 0.0);
+  if (verbose) tee(fl,"\nSwitching to LoP-2:\n");
+}
+
+/*************************************************************************/
+_Thread_local const char *outputDir = ".";   // where the tables go 
+
+FILE *openOutput(const char *name) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", outputDir, name);
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) fatal(1, "\nCould not write %s.\n", path);
+  return fp;
 }
 
 /*************************************************************************/
 void shiftTable() {    // prints the shift table and the shiftECLInput.csv
   FILE *fp;
   FILE *fe;
-  fp = fopen("ShiftTable.txt","w");
-  fe = fopen("ShiftECLInput.csv", "w");
+  fp = openOutput("ShiftTable.txt");
+  fe = openOutput("ShiftECLInput.csv");
 
-  printf("\nShift Table\n\n");
-  fprintf(fp,"\nShift Table\n\n");
+  tee(fp,"\nShift Table\n\n");
   int iOpen = 0;
   int iFill = 0;
   for (int is = 0; is < NSHIFTS; is++) {
     if (shift[is].open){
       iOpen++;  
-      printf("%3d %6s %5s: Open\n", is, shift[is].date, shift[is].type);
-      fprintf(fp,"%3d %6s %5s: Open\n", is, shift[is].date, shift[is].type);
+      tee(fp,"%3d %6s %5s: Open\n", is, shift[is].date, shift[is].type);
     }
     else {
       iFill++;
       int i = shift[is].assigned;           // assigned  shifter 
       int h = ind[i].home;
-      printf("%3d %6s %5s: %-25s%-20s%-15s\n", is,
-	shift[is].date, shift[is].type, ind[i].name, ind[i].ECLID, inst[h].name);
-      fprintf(fp,"%3d %6s %5s: %-25s%-20s%-15s\n", is,
+      tee(fp,"%3d %6s %5s: %-25s%-20s%-15s\n", is,
 	shift[is].date, shift[is].type, ind[i].name, ind[i].ECLID, inst[h].name);
       shift[is].ECLDate[10] = '\0';   // I do not know why this is necessary, but it is
-      fprintf(fe,"%s,%s,Control Room,%s\r",ind[i].ECLID,shift[is].ECLType,
-	      shift[is].ECLDate);
+      put(fe,"%s,%s,Control Room,%s\r",ind[i].ECLID,shift[is].ECLType,
+	  shift[is].ECLDate);
     }
   }
-  printf("\nNumber of filled shifts = %d; number of open shifts = %d\n",
-         iFill, iOpen);
-  fprintf(fp,"\nNumber of filled shifts = %d; number of open shifts = %d\n",
-	 iFill, iOpen);
-  fclose(fp);
-  fclose(fe);
+  tee(fp,"\nNumber of filled shifts = %d; number of open shifts = %d\n",
+      iFill, iOpen);
+  teeClose(fp);
+  teeClose(fe);
 }
 
 /*************************************************************************/
 void shifterTable() {  // prints the shifter table 
   FILE *fp;
-  fp = fopen("ShifterTable.txt", "w");
+  fp = openOutput("ShifterTable.txt");
   
-  printf("\nShifter Table\n\n");
-  fprintf(fp,"\nShifter Table\n\n");
-  printf("Fields are points requested, points assigned, shifts assigned,\n");
-  printf("shifts requested at LoP1, and shifts requested at LoP2\n");
-  fprintf(fp, "Fields are points requested, points assigned, shifts assigned,\n");
-  fprintf(fp, "shifts requested at LoP1, and shifts requested at LoP2\n");
+  tee(fp,"\nShifter Table\n\n");
+  tee(fp, "Fields are points requested, points assigned, shifts assigned,\n");
+  tee(fp, "shifts requested at LoP1, and shifts requested at LoP2\n");
   for (int i = 0; i < nInd; i++) {
     int h = ind[i].home;
-    printf("%-25s%-15s%3d%3d%3d%5d%5d\n", ind[i].name, inst[h].name,
-         ind[i].request, ind[i].nPAssigned, ind[i].nSAssigned, 
-         ind[i].nLoP1, ind[i].nLoP2);
-    fprintf(fp,"%-25s%-15s%3d%3d%3d%5d%5d\n", ind[i].name, inst[h].name,
-         ind[i].request, ind[i].nPAssigned, ind[i].nSAssigned, 
-         ind[i].nLoP1, ind[i].nLoP2);
+    tee(fp,"%-25s%-15s%3d%3d%3d%5d%5d\n", ind[i].name, inst[h].name,
+        ind[i].request, ind[i].nPAssigned, ind[i].nSAssigned, 
+        ind[i].nLoP1, ind[i].nLoP2);
   }
-  fclose(fp);
+  teeClose(fp);
 }
 
 /*************************************************************************/
@@ -1248,21 +2213,22 @@ void deficiencyReport(int i) {
   /* writes a deficiency Report for institution i. These reports are ordered
      by insstitutionalTable under the control of defRep.*/
 
-  printf("\n\n\n%-14s has requested %d points for a quota of %d points\n\n",
-	 inst[i].name, inst[i].nPRequested, inst[i].quota); 
-  printf("Current requests:\n\n");
+  tee(NULL, "\n\n\n%-14s has requested %d points for a quota of %d points\n\n",
+      inst[i].name, inst[i].nPRequested, inst[i].quota); 
+  tee(NULL, "Current requests:\n\n");
   
   for (int ii = 0; ii < nInd; ii++) {
     if (ind[ii].home != i) continue;
-    printf("%-25s%5d points\n",ind[ii].name, ind[ii].request);
+    tee(NULL, "%-25s%5d points\n",ind[ii].name, ind[ii].request);
   }
 
 }
 
 /*************************************************************************/
-int openShifts;  // globals                     
-int chisq;
-int chisqInd;    // Individual chisq shifted so 0 is the lowest possible
+_Thread_local int openShifts;  // globals                     
+_Thread_local int chisq;
+_Thread_local int chisqInd;    /* Individual chisq shifted so 0 is the lowest
+                                  possible */
 /*************************************************************************/
 void report () {
 
@@ -1283,51 +2249,39 @@ void report () {
 /*************************************************************************/
 void institutionTable() {  // print the institution table 
   FILE *fp;
-  fp = fopen("InstitutionTable.txt", "w");
+  fp = openOutput("InstitutionTable.txt");
 
-  printf("\nInstitution Table\n\n");
-  fprintf(fp,"\nInstitution Table\n\n");
+  tee(fp,"\nInstitution Table\n\n");
 
   // printf("Institutions that have met, exceeded, or come within 1 point of\n");
   // printf("Institutions\n\n");
   // fprintf(fp,"Institutions that have met, exceeded, or come within 1 point\n");
   // fprintf(fp,"Institutions\n\n");
 
-  printf("%-15s%14s%7s%10s%11s\n", " ", "Points ", " ", "Points ", " ");
-  printf("%-15s%14s%7s%10s%12s\n\n", "Institution","Requested", "Quota", 
-         "Assigned", "  Difference");
-  fprintf(fp,"%-15s%14s%7s%10s%11s\n", " ","Points ", " ", "Points ", " ");
-  fprintf(fp,"%-15s%14s%7s%10s%12s\n\n", "Institution","Requested", "Quota",
-         "Assigned", "  Difference");
+  tee(fp,"%-15s%14s%7s%10s%11s\n", " ","Points ", " ", "Points ", " ");
+  tee(fp,"%-15s%14s%7s%10s%12s\n\n", "Institution","Requested", "Quota",
+      "Assigned", "  Difference");
 
   for (int i = 1; i <= nInst; i++) { 
     int diff = inst[i].nPAssigned - inst[i].quota;  
     if (true) {  
-      printf("%-15s%11d%8d%9d%10d\n", inst[i].name, inst[i].nPRequested, 
-	     inst[i].quota, inst[i].nPAssigned, diff);
-      fprintf(fp,"%-15s%11d%8d%9d%10d\n", inst[i].name, inst[i].nPRequested,
-             inst[i].quota, inst[i].nPAssigned, diff);
+      tee(fp,"%-15s%11d%8d%9d%10d\n", inst[i].name, inst[i].nPRequested,
+          inst[i].quota, inst[i].nPAssigned, diff);
     }
   }
-  /* printf("\nInstitutions that are more than 1 point short of  their quota.\n\n");
-  fprintf(fp,"\nInstitutions that are more than 1 point short of  their quota.\n\n");
-  printf("%-15s%14s%7s%10s%11s\n", " ","Points ", " ", "Points ", " ");
-  printf("%-15s%14s%7s%10s%12s\n\n", "Institution","Requested", "Quota",
-         "Assigned", "  Difference");
-  fprintf(fp,"%-15s%14s%7s%10s%11s\n", " ","Points ", " ", "Points ", " ");
-  fprintf(fp,"%-15s%14s%7s%10s%12s\n\n", "Institution","Requested", "Quota",
-	  "Assigned", "  Difference");
+  /* tee(fp,"\nInstitutions that are more than 1 point short of  their quota.\n\n");
+  tee(fp,"%-15s%14s%7s%10s%11s\n", " ","Points ", " ", "Points ", " ");
+  tee(fp,"%-15s%14s%7s%10s%12s\n\n", "Institution","Requested", "Quota",
+      "Assigned", "  Difference");
 
   for (int i = 1; i <= nInst; i++) {
     int diff = inst[i].nPAssigned - inst[i].quota;
     if (diff < - 1) { 
-      printf("%-15s%11d%8d%9d%10d\n", inst[i].name, inst[i].nPRequested,
-             inst[i].quota, inst[i].nPAssigned, diff);
-      fprintf(fp,"%-15s%11d%8d%9d%10d\n", inst[i].name, inst[i].nPRequested,
-	      inst[i].quota, inst[i].nPAssigned, diff);
+      tee(fp,"%-15s%11d%8d%9d%10d\n", inst[i].name, inst[i].nPRequested,
+          inst[i].quota, inst[i].nPAssigned, diff);
     }
     } */
-  fclose(fp);
+  teeClose(fp);
 
   
   for (int i = 1; i <= nInst; i++) {       // issue deficiency reports 
@@ -1337,7 +2291,7 @@ void institutionTable() {  // print the institution table
   }
 
   report();
-  printf ("\nAbsolute points sum difference = %d\nChisq = %d\nIndChisq = %d\n", openShifts, chisq, chisqInd);  
+  tee (NULL, "\nAbsolute points sum difference = %d\nChisq = %d\nIndChisq = %d\n", openShifts, chisq, chisqInd);  
 
 }
 
@@ -1363,11 +2317,12 @@ void findDonors() {
       bool consecu = false;
       for (int ir = 0; ir < ind[ii].nSAssigned; ir++) {// look for consec shift
         int rdiff = abs(is - ind[ii].assigned[ir]);
-	if (rdiff && rdiff <= 6) consecu = true;
+	if (rdiff && rdiff <= rules->consecKept*pattern->perDay) consecu = true;
       } 
       if (consecu) continue; 
     }                                             // donor shift found 
-    shift[is].donPri = 10*diff + ind[ii].nPAssigned - ind[ii].request;
+    shift[is].donPri = tuning[TN_DONOR]*diff + ind[ii].nPAssigned - 
+      ind[ii].request;
     nd++;
   }
 }
@@ -1406,6 +2361,8 @@ void assignDonorShift(int is, int ir) {
   int idInst = ind[id].home;        // index of the donor institution 
   int irInst = ind[ir].home;        // index of the receiver institution  
   int points = shift[is].points; 
+  trace(EV_DONATE, 0, is, id, ir, 0.0);
+  tally(CT_DONATION);
 
   shift[is].assigned = ir;                             // #1 above 
   int nShift = ind[ir].nSAssigned;
@@ -1417,7 +2374,7 @@ void assignDonorShift(int is, int ir) {
   float diff = inst[irInst].quota - inst[irInst].nPAssigned;
   if (diff <= 0) killInst(irInst, diff);
 //  if (diff == 1 && inst[irInst].quota > 1) cautionInst(irInst);
-  if (diff == 10 && inst[irInst].quota > 10) cautionInst(irInst);
+  if (cautioned(irInst, diff)) cautionInst(irInst);
 
                                       // find and delete donor shift 
  
@@ -1431,22 +2388,21 @@ void assignDonorShift(int is, int ir) {
   diff = inst[idInst].quota - inst[idInst].nPAssigned;
   if (diff <= 0) killInst(idInst, diff);
 //  if (diff == 1 && inst[idInst].quota > 1) cautionInst(irInst);
-  if (diff == 10 && inst[idInst].quota > 10) cautionInst(irInst);
+  if (cautioned(idInst, diff)) cautionInst(irInst);
 
   if (verbose) {
-    printf("\n%s from %s has graciously donated shift %d %s %s\n",
-      ind[id].name, ind[id].homeName, is, shift[is].date, shift[is].type); 
-    printf("to %s from %s.\n",ind[ir].name, ind[ir].homeName);
-    fprintf(fl,"\n%s from %s has graciously donated shift %d %s %s\n",
-	 ind[id].name, ind[id].homeName, is, shift[is].date, shift[is].type);
-    fprintf(fl,"to %s from %s.\n",ind[ir].name, ind[ir].homeName);
+    tee(fl,"\n%s from %s has graciously donated shift %d %s %s\n",
+	ind[id].name, ind[id].homeName, is, shift[is].date, shift[is].type);
+    tee(fl,"to %s from %s.\n",ind[ir].name, ind[ir].homeName);
   }
   findDonors();
 
 }
 
 /*************************************************************************/
-void findReceiver() {  
+static inline __attribute__((always_inline)) 
+void findReceiverBy(const struct rules *r) {  /* findReceiver under the 
+                                                 rule set r */
 
   /* Qualifications for a donation receiver: 
      (1) Must have requested the shift.
@@ -1456,6 +2412,8 @@ void findReceiver() {
      (4) Its institution must not have reached or exceeded its quota.
      (5) The donation must improve the overal balance (relevant only for
          multi-point shifts).
+     (6) With the rule set's receiverRest, no shift of the receiver within
+         the shortest gap of qualified.
 
      The priority for the receiver is 10*institutional deficit + personal
      deficit - 2*number of shifts assigned to the receiver. */
@@ -1466,10 +2424,12 @@ void findReceiver() {
   int id = shift[is].assigned;
   int idInst = ind[id].home;
   int points = shift[is].points;
-  for (int i = 0; i < nInd; i++) {                      // individual search   
+  int nTry = (engine == FAST) ? nAsked[is] : nInd;    // see engines 
+  for (int it = 0; it < nTry; it++) {                   // individual search
+    int i = (engine == FAST) ? asked[is][it] : it;
     if (! ind[i].active[is]) continue;                     // #1 above 
     if (ind[i].request - ind[i].nPAssigned <= 0) continue; // #2 above 
-    if (ind[i].request - ind[i].nPAssigned - points < 0 && 
+    if (r->overage && ind[i].request - ind[i].nPAssigned - points < 0 && 
         ind[i].over == NO_OVERAGE) continue;               // #3 above 
     int irInst = ind[i].home;                          
     int irDiff = inst[irInst].quota - inst[irInst].nPAssigned;
@@ -1477,11 +2437,17 @@ void findReceiver() {
     int idDiff = inst[idInst].quota - inst[idInst].nPAssigned;
     if (abs(irDiff - points) + abs(idDiff + points) >= 
         abs(irDiff) + abs(idDiff)) continue;               // # 5 above
+    if (r->receiverRest) {
+      bool close = false;
+      for (int isa = 0; isa < ind[i].nSAssigned; isa++) 
+        if (abs(is - ind[i].assigned[isa]) < dayGap[0]) close = true;
+      if (close) continue;                                 // # 6 above 
+    }
    
     // We have a receiver candidate -- calculate priority and save info 
 
-    int priority = 10*irDiff + ind[i].request - ind[i].nPAssigned -
-      2*ind[i].nSAssigned;
+    int priority = tuning[TN_RECEIVER]*irDiff + ind[i].request - 
+      ind[i].nPAssigned - tuning[TN_RECEIVER_SHIFTS]*ind[i].nSAssigned;
     if (priority > maxPri) {
       maxPri = priority;
       ir = i;
@@ -1492,16 +2458,23 @@ void findReceiver() {
   return;
 }
 
+/*************************************************************************/
+void findReceiver() {  
+  if (rules == &icarusRules) findReceiverBy(&icarusRules);
+  else if (rules == &novaRules) findReceiverBy(&novaRules);
+  else findReceiverBy(rules);             // the generic copy 
+}
+
 /*************************************************************************/
 void donationTime() {
 
   int is;
   
+  trace(EV_LOP, 3, 0, 0, 0, 0.0);
   if (verbose) {
-    printf("\nStarting the donation process in which institutions with excess\n");
-    printf("points donate shifts to institutions with a deficit of points\n");
-    fprintf(fl,"\nStarting the donation process in which institutions with excess\n");
-    fprintf(fl," points donate shifts to institutions with a deficit of points\n");
+    tee(fl,"\nStarting the donation process in which institutions with excess\n");
+    tee(NULL,"points donate shifts to institutions with a deficit of points\n");
+    put(fl," points donate shifts to institutions with a deficit of points\n");
   }
   findDonors();
   while (findNextDonor()) findReceiver();
@@ -1509,82 +2482,3179 @@ void donationTime() {
 }
 
 /*************************************************************************/
-int seed[1000000];   // global 
-/*************************************************************************/
-void prepareRandomSeeds() {               // prepare 1,000,000 seeds 
+__attribute__((noreturn)) 
+void missingReport(int n, int *list) {  /* lists the shifters who have no
+                                           base priority and stops */
+  if (onFatal)                      // a library call: just the first one 
+    fatal(1, "Priority not found for %d shifter(s), e.g. %s (%s)", n,
+          ind[list[0]].name, ind[list[0]].ECLID);
+  tee(NULL, "\nPriority not found for %d shifter(s):\n\n", n);
+  for (int im = 0; im < n; im++) {
+    int ii = list[im];
+    tee(NULL, "%-25s%-20sJustification: %s\n", ind[ii].name, ind[ii].ECLID,
+        ind[ii].just);
+  }
+  tee(NULL, "\nAdd them to Pri.csv or choose a --priority policy.\n");
+  exit(1);
+}
 
-  srand(271828183);
+/*************************************************************************/
+void resolvePriorities() {
+
+  /* Shifters who asked for special priority must have an entry in Pri.csv.
+     The input files are read once here to find those who do not, and the
+     priority policy settles all of them before any seed is run.  The
+     settled priorities go to the resolved table, which parseIndFile 
+     searches after Pri.csv. */
+
+  bool saveVerbose = verbose;
+  verbose = false;
+  resolving = true;
+  nMissing = 0;
+  nResolved = -1;               // settled again for every problem 
+  initialization();
+  parseInstFile();
+  parseShiftFile();
+  parsePriFile();
+  parseIndFile();
+  resolving = false;
+  verbose = saveVerbose;
+  if (nMissing == 0) return;
+
+  int unresolved[MAXIND];       // shifters still missing after the policy 
+  int nUnresolved = 0;
+  switch (priPolicy) {
+  case FAIL :
+    missingReport(nMissing, missing);     // does not return 
+  case DEFAULT :
+    for (int im = 0; im < nMissing; im++) {
+      nResolved++;
+      strcpy(resolved[nResolved].ECLID, ind[missing[im]].ECLID);
+      resolved[nResolved].basePri = priDefault;
+    }
+    break;
+  case TABLE :
+    readPriorities(fopen(priTable, "r"), priTable, resolved, &nResolved);
+    for (int im = 0; im < nMissing; im++) 
+      if (! findPriority(missing[im])) unresolved[nUnresolved++] = missing[im];
+    if (nUnresolved > 0) missingReport(nUnresolved, unresolved);
+    break;
+  case ASK :
+    teeDrain();                  // the writer is idle while the user answers 
+    for (int im = 0; im < nMissing; im++) {
+      int ii = missing[im];
+      printf("\nPriority not found for %s (%s).\n", ind[ii].name, 
+             ind[ii].ECLID);
+      printf("Justification: %s\n", ind[ii].just);
+      printf("Please enter the priority.\n");
+      fflush(stdout);
+      float basePri;
+      if (scanf("%f", &basePri) != 1) missingReport(nMissing - im, &missing[im]);
+      nResolved++;
+      strcpy(resolved[nResolved].ECLID, ind[ii].ECLID);
+      resolved[nResolved].basePri = basePri;
+    }
+  }
+}
 
-  for (int i = 0; i < 1000000; i++) seed[i] = rand();
-  
-  return;
+/*************************************************************************/
+void startTrace(char *fileName) {  // opens the trace file and writes header
+  ft = fopen(fileName, "wb");
+  if (ft == NULL) {
+    tee(NULL, "\nCould not open the trace file %s.\n", fileName);
+    exit(1);
+  }
+  int header[3] = {TRACE_MAGIC, NSHIFTS, sizeof(struct event)};
+  fwrite(header, sizeof(int), 3, ft);
+  tracing = true;
 }
 
-/***********************************************************************/
-void main(int argc, char *argv[]) {
+/*************************************************************************/
+void traceSeed(int seedIndex, bool keep) {  /* writes the events of this
+                                               seed if keep; always empties
+                                               the ring */
+  if (! tracing) return;
+  if (keep) {
+    struct traceBlock b;
+    b.seedIndex = seedIndex;
+    b.nEvents = ringCount < RING ? ringCount : RING;
+    b.dropped = ringCount - b.nEvents;
+    int first = ringCount & (RING - 1);  // oldest event after a wrap 
+    if (b.dropped == 0) first = 0;
+    pthread_mutex_lock(&traceLock);
+    fwrite(&b, sizeof(b), 1, ft);
+    fwrite(&ring[first], sizeof(struct event), b.nEvents - first, ft);
+    fwrite(ring, sizeof(struct event), first, ft);
+    pthread_mutex_unlock(&traceLock);
+  }
+  ringCount = 0;
+}
 
-  fl = fopen("AssignLog.txt", "w");  // open the log file 
-  prepareRandomSeeds();
-  
-  bool scanMode;
-  int seedIndex;   
-  int nStop;
-                   
-  if (argc > 1) {
-    scanMode = false;
-    seedIndex = atoi(argv[1]);
-    verbose = true;
-    nStop = 0;                        /* run only once */
+/*************************************************************************/
+void decodeTrace(char *fileName, int seedIndex) {
+
+  /* Renders a trace file as log text, in the words of AssignLog.txt.  The
+     input files supply the names; the points of shifters and institutions
+     are rebuilt by replaying the events.  The trace keeps only the 
+     requester who got a shift, so the other ones are not listed, and 
+     killInst and cautionInst write nothing to the log, so neither does 
+     this.  A seedIndex < 0 renders every seed in the file. */
+
+  FILE *fp = fopen(fileName, "rb");
+  int header[3];
+  if (fp == NULL || fread(header, sizeof(int), 3, fp) != 3 || 
+      header[0] != TRACE_MAGIC || header[1] != NSHIFTS || 
+      header[2] != sizeof(struct event)) {
+    tee(NULL, "\n%s is not a trace file for %d shifts.\n", fileName, NSHIFTS);
+    exit(1);
   }
-  else {
-    scanMode = true;
-    verbose = false;
-    nStop = 999999;                     // run 1,000,000 times 
-  } 
- 
-  int openMin = NSHIFTS;;
-  int chisqMin = 999;
-  int chisqIndMin = 9999;
-
-  for (int iloop = 0; iloop <= nStop; iloop++) {
-    initialization();
-    if (scanMode) srand(seed[iloop]);  // seed random number 
-    else srand(seed[seedIndex]);
-    parseInstFile();            // input institution file
-    parseShiftFile();           // input shift file
-    parsePriFile();             // input priority file
-    parseIndFile();             // input shifter file from the questionnaire 
-    algorithm();                // run on LoP-1 
-    switchLoP();                // switch active file to LoP-2 
-    algorithm();                // run on LoP-2 
-    donationTime();             // wealthy groups donate to the poor 
-    if (!scanMode) {
-      shiftTable();                 // print shift table 
-      shifterTable();               // print shifter table  
-      institutionTable();           // print institution table 
+  struct traceBlock b;
+  struct event e;
+  while (fread(&b, sizeof(b), 1, fp) == 1) {
+    if (seedIndex >= 0 && b.seedIndex != seedIndex) {
+      fseek(fp, (long)b.nEvents*sizeof(struct event), SEEK_CUR);
+      continue;
     }
-    else {
-      report();
-      //      if (openShifts < 0) printf("seed %d flag\n", iloop); 
-      if (openShifts < openMin && openShifts >= 0) { // strange bug -- needs tracking down
-        openMin = openShifts;
-        chisqMin = chisq;           // reset chisq for new openMin
-        chisqIndMin = chisqInd;     // reset chisqInd for new openMin
-      }
-      else if (openShifts == openMin && chisq < chisqMin) {
-        chisqMin = chisq;
-        chisqIndMin = chisqInd;     // reset chisqInd for new chisqMin
-      }
-      else if (openShifts == openMin && chisq == chisqMin && chisqInd < chisqIndMin) {
-        chisqIndMin = chisqInd;
+    tee(NULL, "\n========== seed %d ==========\n", b.seedIndex);
+    if (b.dropped) 
+      tee(NULL, "(the first %d events did not fit in the ring buffer)\n",
+          b.dropped);
+    for (int i = 0; i < nInd; i++) ind[i].nPAssigned = 0;
+    for (int i = 1; i <= nInst; i++) inst[i].nPAssigned = 0;
+    for (int ie = 0; ie < b.nEvents; ie++) {
+      if (fread(&e, sizeof(e), 1, fp) != 1) break;
+      int is = e.shift;
+      int ii = e.who;
+      int iInst = ind[ii].home;
+      switch (e.type) {
+      case EV_LOP :
+        if (e.aux == 1) tee(NULL, "\nAssignments at LoP1:\n");
+        if (e.aux == 2) tee(NULL, "\nSwitching to LoP-2:\n");
+        if (e.aux == 3) {
+          tee(NULL, "\nStarting the donation process in which institutions with excess\n");
+          tee(NULL, " points donate shifts to institutions with a deficit of points\n");
+        }
+        break;
+      case EV_CONSEC :
+        tee(NULL, "\n%s has requested a consecutive shift in anticipation\n",
+            ind[ii].name);
+        tee(NULL, "of being assigned to shift %d: %s %s.\n", is,
+            shift[is].date, shift[is].type);
+        if (e.aux == 1) 
+          tee(NULL, "But this person does not sufficient requested points\n.");
+        if (e.aux == 2) 
+          tee(NULL, "But %s does not sufficient quota points.\n", 
+              inst[iInst].name);
+        if (e.aux == 3) {
+          tee(NULL, "A consecutive shift could not be found, but this person\n");
+          tee(NULL, "will take the shift anyway.\n");
+        }
+        if (e.aux == 4) {
+          tee(NULL, "A consecutive shift could not be found; the shift\n");
+          tee(NULL, "will be recycled\n");
+        }
+        break;
+      case EV_ASSIGN :
+      case EV_TRADE :
+        if (e.aux == 1 + 16) tee(NULL, "An open shift was available:\n");
+        if (e.aux == 1 + 32) 
+          tee(NULL, "\nThis is a shift made available by a trade:");
+        if (e.type == EV_TRADE) tee(NULL, "A trade shift was available:\n");
+        tee(NULL, "\nShift %d %s %s: %d qualified requester(s):\n", is,
+            shift[is].date, shift[is].type, e.other);
+        if (e.type == EV_ASSIGN) {
+          ind[ii].nPAssigned += shift[is].points;
+          inst[iInst].nPAssigned += shift[is].points;
+        }
+        tee(NULL, "%s with priority %5.3f\n", ind[ii].name, e.value);
+        tee(NULL, "Shift has been assigned to %s (%s) from %s.\n",
+            ind[ii].name, ind[ii].ECLID, inst[iInst].name);
+        tee(NULL, "%s has %d of %d requested points.\n", ind[ii].name,
+            ind[ii].nPAssigned, ind[ii].request);
+        tee(NULL, "%s has %d of %d quota points.\n", inst[iInst].name,
+            inst[iInst].nPAssigned, inst[iInst].quota);
+        break;
+      case EV_DONATE : {
+        int ir = e.other;
+        int points = shift[is].points;
+        ind[ii].nPAssigned -= points;
+        inst[ind[ii].home].nPAssigned -= points;
+        ind[ir].nPAssigned += points;
+        inst[ind[ir].home].nPAssigned += points;
+        tee(NULL, "\n%s from %s has graciously donated shift %d %s %s\n",
+            ind[ii].name, ind[ii].homeName, is, shift[is].date, shift[is].type);
+        tee(NULL, "to %s from %s.\n", ind[ir].name, ind[ir].homeName);
+        break;
       }
-      if ((openShifts == openMin && chisq == chisqMin && chisqInd == chisqIndMin) || 
-        iloop % 10000 == 0) {
-	printf ("seed %d open = %d chisq = %d %d\n", iloop, openShifts, chisq, chisqInd);
-        fprintf (fl,"seed %d open = %d chisq = %d &d\n", iloop, openShifts, 
-		 chisq, chisqInd);
       }
     }
-  }    
-  fclose(fl);
+  }
+  fclose(fp);
+}
+
+/*************************************************************************/
+void dumpProfile(char *fileName, double wall) {  /* writes the merged 
+                                                    profile as JSON */
+  mergeProfile();
+  FILE *fp = fopen(fileName, "w");
+  if (fp == NULL) {
+    tee(NULL, "\nCould not open the profile file %s.\n", fileName);
+    return;
+  }
+  bool hw = perfCounters && hwWorked;
+  put(fp, "{\n  \"wallSeconds\": %.6f,\n", wall);
+  put(fp, "  \"hardwareCounters\": %s,\n", hw ? "true" : "false");
+  put(fp, "  \"phases\": {\n");
+  for (int p = 0; p < NPHASES; p++) {
+    put(fp, "    \"%s\": {\"calls\": %ld, \"seconds\": %.6f", phaseName[p],
+        totalProf.calls[p], totalProf.seconds[p]);
+    if (hw) 
+      for (int ih = 0; ih < NHW; ih++) 
+        put(fp, ", \"%s\": %lld", hwName[ih], totalProf.hw[p][ih]);
+    put(fp, "}%s\n", p < NPHASES - 1 ? "," : "");
+  }
+  put(fp, "  },\n  \"counters\": {\n");
+  for (int c = 0; c < NCOUNTERS; c++) 
+    put(fp, "    \"%s\": %ld%s\n", counterName[c], totalProf.count[c],
+        c < NCOUNTERS - 1 ? "," : "");
+  put(fp, "  }\n}\n");
+  teeClose(fp);
+}
+
+/*************************************************************************/
+int seed[1000000];   // global 
+_Thread_local int runningSeed;   // the index of the seed being run 
+_Thread_local int branch = 0;    /* its continuation after LoP-1, 0 for the
+                                    seed itself (see branches) */
+/*************************************************************************/
+void prepareRandomSeeds() {               // prepare 1,000,000 seeds 
+
+  seedRandom(271828183);
+
+  for (int i = 0; i < 1000000; i++) seed[i] = nextRandom();
+  
+  return;
+}
+
+/*************************************************************************/
+void loadSeed(int seedIndex) {   // reads the input and seeds the priorities 
+  initialization();
+  runningSeed = seedIndex;
+  seedRandom(seed[seedIndex]);  // seed random number 
+  phaseStart(PH_PARSE);
+  parseInstFile();            // input institution file
+  parseShiftFile();           // input shift file
+  parsePriFile();             // input priority file
+  parseIndFile();             // input shifter file from the questionnaire 
+  if (engine == FAST) listRequests();
+  phaseStop(PH_PARSE);
+}
+
+/*************************************************************************/
+void runLoP2() {             // the rest of a seed once LoP-1 is done 
+  switchLoP();                // switch active file to LoP-2 
+  if (branch > 0) {           // a continuation of the seed (see branches) 
+    seedRandom(seed[runningSeed] + 2654435761u*branch);
+    getNewRandPri();
+    if (verbose) tee(fl, "Continuation %d: new random priorities\n", branch);
+  }
+  algorithm();                // run on LoP-2 
+  phaseStart(PH_DONATION);
+  donationTime();             // wealthy groups donate to the poor 
+  phaseStop(PH_DONATION);
+}
+
+/*************************************************************************/
+void runSeed() {             // runs the algorithm on the loaded seed 
+  algorithm();                // run on LoP-1 
+  runLoP2();
+}
+
+/*************************************************************************/
+void solveSeed(int seedIndex) {  // runs the whole algorithm for one seed 
+  tally(CT_SEEDS);
+  loadSeed(seedIndex);
+  runSeed();
+}
+
+/*************************************************************************/
+/* The library (see assign.h).  A problem keeps the state of a seed as the
+   parse routines leave it.  startSeed copies it into the state of the 
+   thread and draws the random priorities in the order parseIndFile does,
+   so a seed gives the same result as when the files are read for it. */
+
+struct problem {
+  struct individual ind[MAXIND];
+  int nInd;
+  struct institution inst[MAXINST];
+  int nInst;
+  struct shifts shift[NSHIFTS];
+  int totShifters, totShifts, totPoints, totRequests, totQuotas;
+  int nAsked[NSHIFTS];
+  int asked[NSHIFTS][MAXIND];
+  int nAsked1[NSHIFTS];
+  int asked1[NSHIFTS][MAXIND];
+  struct neighbors neighbors;
+  float ownPri[MAXIND];    // base priorities before the zero quota rule 
+};
+
+/* The best results of a scan.  The order is the one of the scan: fewer 
+   open shifts, then a lower chisq, then a lower chisqInd, or a weighted 
+   sum of the three; an overfilled quota (openShifts < 0) never wins, 
+   and among overfilled ones the least overfilled is best, as in tuning.
+   A topList keeps the k best, best first, and ties go to the lower seed
+   so that the lists of several threads merge the same way every time. */
+
+struct topList {
+  int k, n;
+  struct result *best;
+};
+
+/*************************************************************************/
+bool better(const struct result *a, const struct result *b, 
+            const double *weights) {  // weights NULL => lexicographic 
+  if ((a->openShifts < 0) != (b->openShifts < 0)) return b->openShifts < 0;
+  int aOpen = abs(a->openShifts), bOpen = abs(b->openShifts);
+  if (weights) 
+    return weights[0]*aOpen + weights[1]*a->chisq + weights[2]*a->chisqInd 
+      < weights[0]*bOpen + weights[1]*b->chisq + weights[2]*b->chisqInd;
+  if (aOpen != bOpen) return aOpen < bOpen;
+  if (a->chisq != b->chisq) return a->chisq < b->chisq;
+  return a->chisqInd < b->chisqInd;
+}
+
+/*************************************************************************/
+void topAdd(struct topList *t, const struct result *r, 
+            const double *weights) {
+  int at = t->n;                    // insertion from the end 
+  while (at > 0 && (better(r, &t->best[at - 1], weights) || 
+                    (! better(&t->best[at - 1], r, weights) && 
+                     (r->seedIndex < t->best[at - 1].seedIndex ||
+                      (r->seedIndex == t->best[at - 1].seedIndex && 
+                       r->branch < t->best[at - 1].branch))))) at--;
+  if (at >= t->k) return;
+  if (t->n < t->k) t->n++;
+  memmove(&t->best[at + 1], &t->best[at], 
+          (t->n - 1 - at)*sizeof(struct result));
+  t->best[at] = *r;
+  t->best[at].assigned = NULL;      // the metrics only 
+  t->best[at].points = NULL;
+}
+
+/*************************************************************************/
+bool reportSeed(const struct result *r, struct result *runBest, 
+                const double *weights) {
+
+  /* The scan reports a seed that beats or ties the best so far.  runBest
+     starts with seedIndex -1, for none yet. */
+
+  if (runBest->seedIndex < 0 ? r->openShifts >= 0 
+                             : better(r, runBest, weights)) {
+    *runBest = *r;
+    return true;
+  }
+  return runBest->seedIndex >= 0 && ! better(runBest, r, weights);
+}
+
+struct solver {
+  const struct problem *p;
+  int nThreads;
+  engineType engine;
+  pthread_t *pool;         // nThreads - 1 threads that wait for ranges 
+  pthread_mutex_t lock;
+  pthread_cond_t wake;     // a range was posted, or stop 
+  pthread_cond_t done;     // the last seed of the range is finished 
+  int range;               // number of ranges posted 
+  int first, n;            // the current range 
+  struct result *r;
+  int next;                // next seed of the range to take 
+  int finished;            // seeds of the range finished 
+  bool stop;
+  int started;             // pool threads started, for their numbers 
+  struct topList *tops;    // one per thread, NULL if none are kept 
+  double weights[3];
+  bool weighted;
+  char *metrics;           // the metrics file, mapped; NULL if none 
+  size_t metricsSize;
+  struct outcomeStats *stats;  // one per thread, NULL if none are kept 
+  double statsStarted;
+  const int *branchOf;     /* the seeds of the range when it is one of 
+                              branches, NULL otherwise */
+  int nBranches;           // branches of each of them 
+};
+
+/* Metrics file.  With --metrics=FILE every seed of a scan leaves its 
+   metrics in FILE, a header and then one column per metric with an entry
+   for each of the 1,000,000 seeds, at the seed index:
+
+     header       "ASGNMETR", the version, the number of seeds and of 
+                  columns, then for each column its name (16 bytes), its 
+                  type ('b' byte, 'i' int32, 'f' float32) and its offset
+     ran          b  1 once the seed has been run, 0 before
+     openShifts, chisq, chisqInd, assignments, trades, donations   i
+     seconds      f  the time the seed took
+
+   Numbers are in the byte order of the machine.  The file is mapped and 
+   each thread writes the entries of the seeds it runs, so no lock is 
+   taken.  A file with the same layout is kept, so that runs over 
+   different ranges fill in the same file.  readMetrics.py reads it. */
+
+#define NMETRICS 8
+#define METRICSVERSION 1
+
+struct metricsHeader {
+  char magic[8];
+  int version, nSeeds, nColumns, reserved;
+  struct {
+    char name[16];
+    int type, reserved;
+    long long offset;
+  } column[NMETRICS];
+};
+
+const char *metricsName[NMETRICS] = {"ran", "openShifts", "chisq", 
+  "chisqInd", "assignments", "trades", "donations", "seconds"};
+const char metricsType[NMETRICS] = "biiiiiif";
+
+/*************************************************************************/
+void metricsLayout(struct metricsHeader *h, size_t *size) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, "ASGNMETR", 8);
+  h->version = METRICSVERSION;
+  h->nSeeds = 1000000;
+  h->nColumns = NMETRICS;
+  long long offset = 4096;           // columns start on a page 
+  for (int c = 0; c < NMETRICS; c++) {
+    strcpy(h->column[c].name, metricsName[c]);
+    h->column[c].type = metricsType[c];
+    h->column[c].offset = offset;
+    offset += ((metricsType[c] == 'b' ? 1 : 4)*1000000LL + 4095) & ~4095LL;
+  }
+  *size = offset;
+}
+
+/*************************************************************************/
+void recordMetrics(struct solver *s, const struct result *r) {
+  struct metricsHeader *h = (struct metricsHeader *)s->metrics;
+  int k = r->seedIndex;
+  int value[NMETRICS] = {1, r->openShifts, r->chisq, r->chisqInd, 
+                         r->assignments, r->trades, r->donations};
+  for (int c = 1; c < NMETRICS - 1; c++) 
+    ((int *)(s->metrics + h->column[c].offset))[k] = value[c];
+  ((float *)(s->metrics + h->column[NMETRICS - 1].offset))[k] = r->seconds;
+  s->metrics[h->column[0].offset + k] = 1;   // last: the entry is whole 
+}
+
+/* Outcome statistics.  With --status=FILE each thread of a scan counts 
+   the outcomes of its seeds in histograms of its own: openShifts, chisq,
+   chisqInd, and the deviation from the quota of every institution.  
+   Between the ranges of seeds, when the threads wait, the histograms are
+   merged and FILE is rewritten as JSON with the rate of the scan and the
+   quantiles of each.  The bins of the seed metrics are exact up to 256
+   and then 256 to each power of 2, for either sign, so a quantile is 
+   within 1/512 of the true value; the deviations of the institutions are
+   small and get a bin each from -64 to 64, the ends taking the rest. */
+
+#define EXACTBINS 256
+#define SUBBINS 256
+#define HALFBINS (EXACTBINS + 23*SUBBINS)   // up to 2^31 
+#define NBINS (2*HALFBINS)
+#define DEVBINS 129
+
+struct moments {
+  long n;
+  int min, max;
+  double sum;
+};
+
+struct histogram {         // of a metric of the seeds 
+  struct moments m;
+  long count[NBINS];
+};
+
+struct deviation {         // of an institution from its quota 
+  struct moments m;
+  long count[DEVBINS];
+};
+
+struct outcomeStats {      // of the seeds run by one thread 
+  struct histogram metric[3];  // openShifts, chisq, chisqInd 
+  struct deviation *inst;  // 1 to nInst 
+};
+
+const char *outcomeName[3] = {"openShifts", "chisq", "chisqInd"};
+
+/*************************************************************************/
+int binOf(int v) {
+  long a = v < 0 ? -(long)v : v;
+  int bin;
+  if (a < EXACTBINS) bin = a;
+  else {
+    int octave = 63 - __builtin_clzl(a);          // at least 8 
+    bin = EXACTBINS + (octave - 8)*SUBBINS + 
+      ((a >> (octave - 8)) & (SUBBINS - 1));
+  }
+  return v < 0 ? HALFBINS - 1 - bin : HALFBINS + bin;
+}
+
+/*************************************************************************/
+double binValue(int bin) {  // the middle of a bin 
+  int b = bin < HALFBINS ? HALFBINS - 1 - bin : bin - HALFBINS;
+  double value;
+  if (b < EXACTBINS) value = b;
+  else {
+    int octave = 8 + (b - EXACTBINS)/SUBBINS;
+    double width = 1L << (octave - 8);
+    value = (1L << octave) + ((b - EXACTBINS)%SUBBINS)*width + width/2 - 0.5;
+  }
+  return bin < HALFBINS ? -value : value;
+}
+
+/*************************************************************************/
+double devValue(int bin) {
+  return bin - DEVBINS/2;
+}
+
+/*************************************************************************/
+void momentsAdd(struct moments *m, int v) {
+  if (m->n == 0 || v < m->min) m->min = v;
+  if (m->n == 0 || v > m->max) m->max = v;
+  m->n++;
+  m->sum += v;
+}
+
+/*************************************************************************/
+void momentsMerge(struct moments *to, const struct moments *from) {
+  if (from->n == 0) return;
+  if (to->n == 0 || from->min < to->min) to->min = from->min;
+  if (to->n == 0 || from->max > to->max) to->max = from->max;
+  to->n += from->n;
+  to->sum += from->sum;
+}
+
+/*************************************************************************/
+double quantile(const struct moments *m, const long *count, int nBins,
+                double (*value)(int), double q) {
+  long rank = (long)(q*(m->n - 1));
+  for (int b = 0; b < nBins; b++) 
+    if ((rank -= count[b]) < 0) {
+      double v = value(b);           // within what was seen 
+      return v < m->min ? m->min : v > m->max ? m->max : v;
+    }
+  return m->max;
+}
+
+/*************************************************************************/
+void histogramAdd(struct histogram *h, int v) {
+  momentsAdd(&h->m, v);
+  h->count[binOf(v)]++;
+}
+
+/*************************************************************************/
+void statsMerge(struct outcomeStats *to, const struct outcomeStats *from,
+                int nInst) {
+  for (int k = 0; k < 3; k++) {
+    momentsMerge(&to->metric[k].m, &from->metric[k].m);
+    for (int b = 0; b < NBINS; b++) 
+      to->metric[k].count[b] += from->metric[k].count[b];
+  }
+  for (int i = 1; i <= nInst; i++) {
+    momentsMerge(&to->inst[i].m, &from->inst[i].m);
+    for (int b = 0; b < DEVBINS; b++) 
+      to->inst[i].count[b] += from->inst[i].count[b];
+  }
+}
+
+/*************************************************************************/
+void recordOutcome(struct outcomeStats *st, const struct result *r) {
+
+  // the state of the thread still holds the seed, for the institutions 
+
+  histogramAdd(&st->metric[0], r->openShifts);
+  histogramAdd(&st->metric[1], r->chisq);
+  histogramAdd(&st->metric[2], r->chisqInd);
+  for (int i = 1; i <= nInst; i++) {
+    int v = inst[i].quota - inst[i].nPAssigned;
+    int bin = v + DEVBINS/2;
+    momentsAdd(&st->inst[i].m, v);
+    st->inst[i].count[bin < 0 ? 0 : bin >= DEVBINS ? DEVBINS - 1 : bin]++;
+  }
+}
+
+pthread_mutex_t loadLock = PTHREAD_MUTEX_INITIALIZER;  /* the priority 
+                                                          policy is global */
+pthread_once_t seedsOnce = PTHREAD_ONCE_INIT;
+
+/*************************************************************************/
+bool setPolicy(const char *policy) {  // the -p option; false if unknown 
+  if (strcmp(policy, "ask") == 0) priPolicy = ASK;
+  else if (strcmp(policy, "fail") == 0) priPolicy = FAIL;
+  else if (strncmp(policy, "default:", 8) == 0) {
+    priPolicy = DEFAULT;
+    priDefault = atof(policy + 8);
+  }
+  else if (strncmp(policy, "table:", 6) == 0) {
+    priPolicy = TABLE;
+    strncpy(priTable, policy + 6, sizeof(priTable) - 1);
+  }
+  else return false;
+  return true;
+}
+
+/*************************************************************************/
+struct problem *buildProblem(const char *policy, char *error, 
+                             int errorSize) {
+
+  /* Reads the input from inputDir or inputText.  Errors come back here 
+     through fatal unless error is NULL. */
+
+  jmp_buf env;
+  struct problem *volatile p = malloc(sizeof(struct problem));  /* kept 
+                                                 across the longjmp */
+  bool saveVerbose = verbose;
+  pthread_once(&seedsOnce, prepareRandomSeeds);
+  pthread_mutex_lock(&loadLock);
+  if (error) {
+    onFatal = &env;
+    fatalText = error;
+    fatalSize = errorSize;
+    if (setjmp(env)) {
+      onFatal = NULL;
+      resolving = false;
+      verbose = saveVerbose;
+      pthread_mutex_unlock(&loadLock);
+      free(p);
+      return NULL;
+    }
+  }
+  if (! setPolicy(policy ? policy : "fail")) 
+    fatal(1, "Unknown priority policy %s\n", policy);
+  resolvePriorities();
+  verbose = false;
+  initialization();
+  parseInstFile();
+  parseShiftFile();
+  parsePriFile();
+  parseIndFile();
+  listRequests();
+  for (int ii = 0; ii < nInd; ii++) {    // as parseIndFile sets them 
+    float basePri = ind[ii].basePri;
+    if (ind[ii].special == NO) ind[ii].basePri = 1.0;
+    else if (! findPriority(ii)) ind[ii].basePri = 0.0;
+    p->ownPri[ii] = ind[ii].basePri;
+    ind[ii].basePri = basePri;
+  }
+  verbose = saveVerbose;
+  onFatal = NULL;
+  pthread_mutex_unlock(&loadLock);
+
+  memcpy(p->ind, ind, sizeof(ind));
+  p->nInd = nInd;
+  memcpy(p->inst, inst, sizeof(inst));
+  p->nInst = nInst;
+  memcpy(p->shift, shift, sizeof(shift));
+  p->totShifters = totShifters;
+  p->totShifts = totShifts;
+  p->totPoints = totPoints;
+  p->totRequests = totRequests;
+  p->totQuotas = totQuotas;
+  memcpy(p->nAsked, nAsked, sizeof(nAsked));
+  memcpy(p->asked, asked, sizeof(asked));
+  memcpy(p->nAsked1, nAsked1, sizeof(nAsked1));
+  memcpy(p->asked1, asked1, sizeof(asked1));
+  p->neighbors = neighbors;
+  return p;
+}
+
+/*************************************************************************/
+struct problem *loadProblem(const char *dir, const char *policy, 
+                            char *error, int errorSize) {
+  inputDir = dir;
+  struct problem *p = buildProblem(policy, error, errorSize);
+  inputDir = ".";
+  return p;
+}
+
+/*************************************************************************/
+struct problem *parseProblem(const char *instText, const char *shiftText,
+                             const char *priText, const char *indText,
+                             const char *policy, char *error, int errorSize) {
+  inputText[INST_FILE] = instText;
+  inputText[SHIFT_FILE] = shiftText;
+  inputText[PRI_FILE] = priText;
+  inputText[IND_FILE] = indText;
+  struct problem *p = buildProblem(policy, error, errorSize);
+  memset(inputText, 0, sizeof(inputText));
+  return p;
+}
+
+/*************************************************************************/
+void freeProblem(struct problem *p) {
+  free(p);
+}
+
+/*************************************************************************/
+int problemShifts(const struct problem *p) {
+  (void)p;                           // the same for every problem 
+  return NSHIFTS;
+}
+
+/*************************************************************************/
+int problemShifters(const struct problem *p) {
+  return p->nInd;
+}
+
+/*************************************************************************/
+const char *shifterName(const struct problem *p, int ii) {
+  return (ii >= 0 && ii < p->nInd) ? p->ind[ii].name : NULL;
+}
+
+/*************************************************************************/
+unsigned long long fnv(unsigned long long h, const void *data, size_t n) {
+  for (size_t k = 0; k < n; k++) {   // FNV-1a 
+    h ^= ((const unsigned char *)data)[k];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+/*************************************************************************/
+unsigned long long problemFingerprint(const struct problem *p) {
+
+  /* A hash of what the seeds depend on, the priorities as resolved 
+     included, so that results of separate runs can be matched to their
+     input */
+
+  unsigned long long h = 0xcbf29ce484222325ULL;
+  h = fnv(h, &p->nInd, sizeof(int));
+  for (int ii = 0; ii < p->nInd; ii++) {
+    const struct individual *d = &p->ind[ii];
+    int fields[8] = {d->home, d->request, d->over, d->special, d->consec,
+                     d->rest, d->strict, d->nonConsec};
+    float pri[3] = {d->basePri, d->virginPri, d->bonusPri};
+    h = fnv(h, d->ECLID, strlen(d->ECLID) + 1);
+    h = fnv(h, fields, sizeof(fields));
+    h = fnv(h, pri, sizeof(pri));
+    h = fnv(h, d->lop1, sizeof(d->lop1));
+    h = fnv(h, d->lop2, sizeof(d->lop2));
+  }
+  h = fnv(h, &p->nInst, sizeof(int));
+  for (int i = 1; i <= p->nInst; i++) {
+    h = fnv(h, p->inst[i].name, strlen(p->inst[i].name) + 1);
+    h = fnv(h, &p->inst[i].quota, sizeof(int));
+  }
+  for (int is = 0; is < NSHIFTS; is++) {
+    int fields[2] = {p->shift[is].points, p->shift[is].stype};
+    h = fnv(h, fields, sizeof(fields));
+  }
+  for (int t = 0; t < NTUNING; t++)  /* the constants, if changed, so that
+                                        a default run hashes as before */
+    if (tuning[t] != tuningDefault[t]) {
+      h = fnv(h, &t, sizeof(t));
+      h = fnv(h, &tuning[t], sizeof(tuning[t]));
+    }
+  if (fixedPri) h = fnv(h, "fixed", 5);
+  if (pattern != &patterns[0]) h = fnv(h, pattern->name, strlen(pattern->name));
+  if (rules != &icarusRules) h = fnv(h, rules->name, strlen(rules->name));
+  return h;
+}
+
+/*************************************************************************/
+/* Scenarios.  A copy of a problem can be given other quotas or requests 
+   without reading the input again; the changes are made as parsing the
+   edited files would make them (the request totals, and a zero quota
+   zeroes the base priorities of its shifters), and the random 
+   priorities of a seed are drawn as before. */
+
+struct problem *copyProblem(const struct problem *p) {
+  struct problem *copy = malloc(sizeof(struct problem));
+  memcpy(copy, p, sizeof(struct problem));
+  return copy;
+}
+
+/*************************************************************************/
+int findInstitution(const struct problem *p, const char *name) {
+  for (int i = 1; i <= p->nInst; i++) 
+    if (strcmp(p->inst[i].name, name) == 0) return i;
+  return -1;
+}
+
+/*************************************************************************/
+int findShifter(const struct problem *p, const char *shifter) {  /* by 
+                                                         ECLID or name */
+  for (int ii = 0; ii < p->nInd; ii++) 
+    if (strcmp(p->ind[ii].ECLID, shifter) == 0 || 
+        strcmp(p->ind[ii].name, shifter) == 0) return ii;
+  return -1;
+}
+
+/*************************************************************************/
+int setQuota(struct problem *p, const char *institution, int quota) {
+  int i = findInstitution(p, institution);
+  if (i < 0 || quota < 0) return -1;
+  int old = p->inst[i].quota;
+  p->inst[i].quota = quota;
+  p->totQuotas += quota - old;
+  for (int ii = 0; ii < p->nInd; ii++) 
+    if (p->ind[ii].home == i) 
+      p->ind[ii].basePri = quota == 0 ? 0.0 : p->ownPri[ii];
+  listCandidates(p->ind, p->nInd, p->shift, p->nAsked, p->asked, 
+                 p->nAsked1, p->asked1);
+  return old;
+}
+
+/*************************************************************************/
+int setRequestOf(struct problem *p, int ii, int points) {  /* setRequest 
+                                                   by the shifter's index */
+  struct individual *d = &p->ind[ii];
+  int old = d->request;
+  d->request = points;
+  p->totRequests += points - old;
+  p->totShifters += (points > 0) - (old > 0);
+  p->inst[d->home].nPRequested += points - old;
+  listCandidates(p->ind, p->nInd, p->shift, p->nAsked, p->asked, 
+                 p->nAsked1, p->asked1);
+  return old;
+}
+
+/*************************************************************************/
+int setRequest(struct problem *p, const char *shifter, int points) {
+  int ii = findShifter(p, shifter);
+  if (ii < 0 || points < 0) return -1;
+  return setRequestOf(p, ii, points);
+}
+
+/*************************************************************************/
+void startSeed(const struct problem *p, int seedIndex) {  /* loadSeed 
+                                                             without files */
+  phaseStart(PH_PARSE);
+  initialization();
+  ringCount = 0;
+  nInd = p->nInd;
+  nInst = p->nInst;
+  nShift = NSHIFTS - 1;
+  memcpy(ind, p->ind, nInd*sizeof(struct individual));
+  memcpy(inst, p->inst, (nInst + 1)*sizeof(struct institution));
+  memcpy(shift, p->shift, sizeof(shift));
+  totShifters = p->totShifters;
+  totShifts = p->totShifts;
+  totPoints = p->totPoints;
+  totRequests = p->totRequests;
+  totQuotas = p->totQuotas;
+  if (engine == FAST) 
+    for (int is = 0; is < NSHIFTS; is++) {
+      nAsked[is] = p->nAsked[is];
+      memcpy(asked[is], p->asked[is], nAsked[is]*sizeof(int));
+      nAsked1[is] = p->nAsked1[is];
+      memcpy(asked1[is], p->asked1[is], nAsked1[is]*sizeof(int));
+    }
+  if (engine == FAST) neighbors = p->neighbors;
+  runningSeed = seedIndex;
+  seedRandom(seed[seedIndex]);
+  for (int ii = 0; ii < nInd; ii++) {   // as at the end of parseIndFile 
+    ind[ii].virginPri = tuning[TN_VIRGIN];     // --param may have changed
+    if (ind[ii].extraVirgin) ind[ii].virginPri += tuning[TN_EXTRA_V];
+    drawRandPri(ii);
+    sumPri(ii);
+  }
+  phaseStop(PH_PARSE);
+}
+
+/*************************************************************************/
+void takeResult(int seedIndex, struct result *r) {  // report into r 
+  phaseStart(PH_REPORT);
+  report();
+  r->seedIndex = seedIndex;
+  r->branch = branch;
+  r->openShifts = openShifts;
+  r->chisq = chisq;
+  r->chisqInd = chisqInd;
+  if (r->assigned) 
+    for (int is = 0; is < NSHIFTS; is++) 
+      r->assigned[is] = shift[is].open ? -1 : shift[is].assigned;
+  if (r->points) 
+    for (int ii = 0; ii < nInd; ii++) r->points[ii] = ind[ii].nPAssigned;
+  r->assignments = seedCount[CT_ASSIGN];
+  r->trades = seedCount[CT_TRADE];
+  r->donations = seedCount[CT_DONATION];
+  phaseStop(PH_REPORT);
+}
+
+/*************************************************************************/
+void solveProblem(const struct problem *p, int seedIndex) {  /* solveSeed 
+                                                               without files */
+  tally(CT_SEEDS);
+  startSeed(p, seedIndex);
+  runSeed();
+}
+
+/*************************************************************************/
+int solveOne(struct solver *s, int seedIndex, struct result *r) {
+  if (seedIndex < 0 || seedIndex >= 1000000) return -1;
+  engineType saveEngine = engine;
+  engine = s->engine;
+  double started = now();
+  solveProblem(s->p, seedIndex);
+  takeResult(seedIndex, r);
+  r->seconds = now() - started;
+  engine = saveEngine;
+  return 0;
+}
+
+/*************************************************************************/
+/* Branches.  LoP-2 and the donation decide much of the outcome of a seed,
+   so the scan can go on from the best seeds by running the rest of each
+   again with other random priorities: branch B of seed S is seed S up to
+   the switch to LoP-2 and then the generator seeded with seed[S] + 
+   2654435761*B, where branch 0 is the seed itself.  The state at the 
+   switch is a snapshot, taken once per seed in each thread and restored
+   for every branch, so LoP-1 is not run again.  The generator is part of
+   it; the asked lists and totals are those startSeed set for the seed. */
+
+struct snapshot {
+  const struct solver *s;  // the solver and range it was taken in 
+  int range;
+  int seedIndex;
+  struct individual ind[MAXIND];
+  unsigned long long priKey[MAXIND];
+  struct institution inst[MAXINST];
+  struct shifts shift[NSHIFTS];
+  struct consecutive con;
+  int randTable[31], randFront, randRear;
+  int seedCount[NCOUNTERS];
+  int nextShift, donorShift;
+  bool noMultiPoint;
+};
+_Thread_local struct snapshot *snap;   // of this thread, NULL before one 
+
+/*************************************************************************/
+void takeSnapshot(struct snapshot *sn) {  // the state at the end of LoP-1 
+  memcpy(sn->ind, ind, (nInd + 1)*sizeof(struct individual));
+  memcpy(sn->priKey, priKey, (nInd + 1)*sizeof(priKey[0]));
+  memcpy(sn->inst, inst, (nInst + 1)*sizeof(struct institution));
+  memcpy(sn->shift, shift, sizeof(shift));
+  sn->con = con;
+  memcpy(sn->randTable, randTable, sizeof(randTable));
+  sn->randFront = randFront;
+  sn->randRear = randRear;
+  memcpy(sn->seedCount, seedCount, sizeof(seedCount));
+  sn->nextShift = nextShift;
+  sn->donorShift = donorShift;
+  sn->noMultiPoint = noMultiPoint;
+}
+
+/*************************************************************************/
+void restoreSnapshot(const struct snapshot *sn) {
+  memcpy(ind, sn->ind, (nInd + 1)*sizeof(struct individual));
+  memcpy(priKey, sn->priKey, (nInd + 1)*sizeof(priKey[0]));
+  memcpy(inst, sn->inst, (nInst + 1)*sizeof(struct institution));
+  memcpy(shift, sn->shift, sizeof(shift));
+  con = sn->con;
+  memcpy(randTable, sn->randTable, sizeof(randTable));
+  randFront = sn->randFront;
+  randRear = sn->randRear;
+  memcpy(seedCount, sn->seedCount, sizeof(seedCount));
+  nextShift = sn->nextShift;
+  donorShift = sn->donorShift;
+  noMultiPoint = sn->noMultiPoint;
+  lop1 = true;
+  ringCount = 0;
+}
+
+/*************************************************************************/
+void solveBranch(struct solver *s, int seedIndex, int b, struct result *r) {
+  engineType saveEngine = engine;
+  engine = s->engine;
+  double started = now();
+  if (snap == NULL) snap = calloc(1, sizeof(struct snapshot));
+  if (snap->s != s || snap->range != s->range || 
+      snap->seedIndex != seedIndex) {        // LoP-1 of a new seed 
+    startSeed(s->p, seedIndex);
+    algorithm();
+    takeSnapshot(snap);
+    snap->s = s;
+    snap->range = s->range;
+    snap->seedIndex = seedIndex;
+  }
+  else restoreSnapshot(snap);    /* the thread ran only branches of the
+                                    problem since, so the rest is as 
+                                    startSeed left it */
+  branch = b;
+  runLoP2();
+  takeResult(seedIndex, r);
+  branch = 0;
+  r->seconds = now() - started;
+  engine = saveEngine;
+}
+
+/*************************************************************************/
+void workRange(struct solver *s, int id) {  /* takes seeds of the current
+                                               range until there are none
+                                               left; id 0 is the caller */
+  pthread_mutex_lock(&s->lock);
+  while (s->next < s->n) {
+    int k = s->next++;
+    pthread_mutex_unlock(&s->lock);
+    if (s->branchOf) 
+      solveBranch(s, s->branchOf[k/s->nBranches], k%s->nBranches + 1, 
+                  &s->r[k]);
+    else {
+      solveOne(s, s->first + k, &s->r[k]);
+      if (s->metrics) recordMetrics(s, &s->r[k]);
+      if (s->stats) recordOutcome(&s->stats[id], &s->r[k]);
+    }
+    if (s->tops) 
+      topAdd(&s->tops[id], &s->r[k], s->weighted ? s->weights : NULL);
+    pthread_mutex_lock(&s->lock);
+    if (++s->finished == s->n) pthread_cond_broadcast(&s->done);
+  }
+  pthread_mutex_unlock(&s->lock);
+}
+
+/*************************************************************************/
+void *poolThread(void *arg) {  // a thread of the pool of a solver 
+  struct solver *s = arg;
+  int seen = 0;                // ranges already worked on 
+  pthread_mutex_lock(&s->lock);
+  int id = ++s->started;
+  while (true) {
+    while (s->range == seen && ! s->stop) pthread_cond_wait(&s->wake, &s->lock);
+    if (s->stop) break;
+    seen = s->range;
+    pthread_mutex_unlock(&s->lock);
+    workRange(s, id);
+    pthread_mutex_lock(&s->lock);
+  }
+  pthread_mutex_unlock(&s->lock);
+  mergeProfile();
+  free(snap);
+  return NULL;
+}
+
+/*************************************************************************/
+struct solver *newSolver(const struct problem *p, int nThreads) {
+
+  /* The calling thread works on the ranges too, so the pool has one
+     thread less than the solver */
+
+  struct solver *s = calloc(1, sizeof(struct solver));
+  s->p = p;
+  s->nThreads = nThreads < 1 ? 1 : nThreads;
+  s->engine = FAST;
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->wake, NULL);
+  pthread_cond_init(&s->done, NULL);
+  s->pool = malloc(s->nThreads*sizeof(pthread_t));
+  for (int it = 0; it < s->nThreads - 1; it++) 
+    startThread(&s->pool[it], poolThread, s);
+  return s;
+}
+
+/*************************************************************************/
+void solverReference(struct solver *s, int reference) {
+  s->engine = reference ? REFERENCE : FAST;
+}
+
+/*************************************************************************/
+void freeSolver(struct solver *s) {
+  pthread_mutex_lock(&s->lock);
+  s->stop = true;
+  pthread_cond_broadcast(&s->wake);
+  pthread_mutex_unlock(&s->lock);
+  for (int it = 0; it < s->nThreads - 1; it++) pthread_join(s->pool[it], NULL);
+  pthread_mutex_destroy(&s->lock);
+  pthread_cond_destroy(&s->wake);
+  pthread_cond_destroy(&s->done);
+  solverTop(s, 0, NULL);
+  if (s->metrics) munmap(s->metrics, s->metricsSize);
+  solverStats(s, false);
+  free(s->pool);
+  free(s);
+}
+
+/*************************************************************************/
+void solverTop(struct solver *s, int k, const double *weights) {
+  if (s->tops) 
+    for (int it = 0; it < s->nThreads; it++) free(s->tops[it].best);
+  free(s->tops);
+  s->tops = NULL;
+  s->weighted = weights != NULL;
+  if (weights) memcpy(s->weights, weights, sizeof(s->weights));
+  if (k <= 0) return;
+  s->tops = calloc(s->nThreads, sizeof(struct topList));
+  for (int it = 0; it < s->nThreads; it++) {
+    s->tops[it].k = k;
+    s->tops[it].best = malloc(k*sizeof(struct result));
+  }
+}
+
+/*************************************************************************/
+int solverMetrics(struct solver *s, const char *fileName) {
+  struct metricsHeader layout;
+  size_t size;
+  metricsLayout(&layout, &size);
+  FILE *fp = fopen(fileName, "r+");  // kept if it is there 
+  if (fp == NULL) fp = fopen(fileName, "w+");
+  if (fp == NULL) return -1;
+  int fd = fileno(fp);
+  struct stat st;
+  struct metricsHeader old;
+  bool keep = fstat(fd, &st) == 0 && (size_t)st.st_size == size &&
+    pread(fd, &old, sizeof(old), 0) == sizeof(old) && 
+    memcmp(&old, &layout, sizeof(old)) == 0;
+  if (! keep && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0 ||
+                 pwrite(fd, &layout, sizeof(layout), 0) != sizeof(layout))) {
+    fclose(fp);
+    return -1;
+  }
+  char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  fclose(fp);                        // the mapping stays 
+  if (map == MAP_FAILED) return -1;
+  if (s->metrics) munmap(s->metrics, s->metricsSize);
+  s->metrics = map;
+  s->metricsSize = size;
+  return 0;
+}
+
+/*************************************************************************/
+void solverStats(struct solver *s, int on) {
+  if (s->stats) 
+    for (int it = 0; it < s->nThreads; it++) free(s->stats[it].inst);
+  free(s->stats);
+  s->stats = NULL;
+  if (! on) return;
+  s->stats = calloc(s->nThreads, sizeof(struct outcomeStats));
+  for (int it = 0; it < s->nThreads; it++) 
+    s->stats[it].inst = calloc(s->p->nInst + 1, sizeof(struct deviation));
+  s->statsStarted = now();
+}
+
+/*************************************************************************/
+void writeDistribution(FILE *fp, const char *indent, const char *name, 
+                       const struct moments *m, const long *count, 
+                       int nBins, double (*value)(int), bool bins) {
+  const double q[5] = {0.01, 0.1, 0.5, 0.9, 0.99};
+  fprintf(fp, "%s\"%s\": {\"min\": %d, \"max\": %d, \"mean\": %.6g, "
+          "\"quantiles\": {", indent, name, m->n ? m->min : 0, 
+          m->n ? m->max : 0, m->n ? m->sum/m->n : 0.0);
+  for (int k = 0; k < 5; k++) 
+    fprintf(fp, "%s\"%g\": %g", k ? ", " : "", q[k], 
+            m->n ? quantile(m, count, nBins, value, q[k]) : 0.0);
+  fprintf(fp, "}");
+  if (bins) {                        // the bins that are not empty 
+    fprintf(fp, ",\n%s  \"histogram\": [", indent);
+    int shown = 0;
+    for (int b = 0; b < nBins; b++) 
+      if (count[b]) 
+        fprintf(fp, "%s[%g, %ld]", shown++ ? ", " : "", value(b), count[b]);
+    fprintf(fp, "]");
+  }
+  fprintf(fp, "}");
+}
+
+/*************************************************************************/
+struct outcomeStats *solverMergedStats(struct solver *s) {  /* the threads'
+                                                               statistics
+                                                               together */
+  static struct outcomeStats all;
+  static struct deviation allInst[MAXINST];
+  memset(&all, 0, sizeof(all));
+  memset(allInst, 0, sizeof(allInst));
+  all.inst = allInst;
+  for (int it = 0; it < s->nThreads; it++) 
+    statsMerge(&all, &s->stats[it], s->p->nInst);
+  return &all;
+}
+
+/*************************************************************************/
+int writeStatus(const char *fileName, const struct outcomeStats *all,
+                const struct problem *p, double seconds) {
+
+  /* The file is written beside and renamed, so whoever watches it never
+     reads half of it.  It does not go through the writer, which would 
+     close it later. */
+
+  char temp[1024];
+  snprintf(temp, sizeof(temp), "%s.new", fileName);
+  FILE *fp = fopen(temp, "w");
+  if (fp == NULL) return -1;
+  long nSeeds = all->metric[0].m.n;
+  fprintf(fp, "{\n  \"seeds\": %ld,\n  \"seconds\": %.3f,\n"
+          "  \"seedsPerSecond\": %.1f,\n", nSeeds, seconds, 
+          seconds > 0 ? nSeeds/seconds : 0.0);
+  for (int k = 0; k < 3; k++) {
+    writeDistribution(fp, "  ", outcomeName[k], &all->metric[k].m, 
+                      all->metric[k].count, NBINS, binValue, true);
+    fprintf(fp, ",\n");
+  }
+  fprintf(fp, "  \"institutions\": {\n");
+  for (int i = 1; i <= p->nInst; i++) {
+    writeDistribution(fp, "    ", p->inst[i].name, &all->inst[i].m, 
+                      all->inst[i].count, DEVBINS, devValue, false);
+    fprintf(fp, "%s\n", i < p->nInst ? "," : "");
+  }
+  fprintf(fp, "  }\n}\n");
+  if (fclose(fp) != 0) return -1;
+  return rename(temp, fileName);
+}
+
+/*************************************************************************/
+int solverStatus(struct solver *s, const char *fileName) {  /* only between
+                                                               ranges */
+  if (s->stats == NULL) return -1;
+  return writeStatus(fileName, solverMergedStats(s), s->p, 
+                     now() - s->statsStarted);
+}
+
+/*************************************************************************/
+int solverBest(struct solver *s, struct result *best) {  /* merges the 
+                                                            lists of the 
+                                                            threads */
+  if (s->tops == NULL) return 0;
+  struct topList merged = {s->tops[0].k, 0, best};
+  for (int it = 0; it < s->nThreads; it++) 
+    for (int k = 0; k < s->tops[it].n; k++) 
+      topAdd(&merged, &s->tops[it].best[k], s->weighted ? s->weights : NULL);
+  return merged.n;
+}
+
+/*************************************************************************/
+int solveRange(struct solver *s, int first, int n, struct result *r) {
+
+  /* Seeds first to first + n - 1 into r[0] to r[n - 1], shared out among
+     the threads of the solver as they become free */
+
+  if (first < 0 || n < 0 || first + n > 1000000) return -1;
+  if (n == 0) return 0;
+  pthread_mutex_lock(&s->lock);
+  s->first = first;
+  s->n = n;
+  s->r = r;
+  s->next = 0;
+  s->finished = 0;
+  s->range++;
+  pthread_cond_broadcast(&s->wake);
+  pthread_mutex_unlock(&s->lock);
+  workRange(s, 0);
+  pthread_mutex_lock(&s->lock);
+  while (s->finished < s->n) pthread_cond_wait(&s->done, &s->lock);
+  pthread_mutex_unlock(&s->lock);
+  return 0;
+}
+
+/*************************************************************************/
+int solveBranches(struct solver *s, const int *seeds, int nSeeds, int n,
+                  struct result *r) {
+
+  /* Branches 1 to n of each seed into r, those of seeds[0] first; the 
+     threads take them in order, so each runs LoP-1 of a seed about once */
+
+  for (int k = 0; k < nSeeds; k++) 
+    if (seeds[k] < 0 || seeds[k] >= 1000000) return -1;
+  if (nSeeds <= 0 || n <= 0) return 0;
+  if (snap) snap->s = NULL;      /* the caller's may be of a solver freed 
+                                    since; the pool's go with their solver */
+  pthread_mutex_lock(&s->lock);
+  s->branchOf = seeds;
+  s->nBranches = n;
+  s->first = 0;
+  s->n = nSeeds*n;
+  s->r = r;
+  s->next = 0;
+  s->finished = 0;
+  s->range++;
+  pthread_cond_broadcast(&s->wake);
+  pthread_mutex_unlock(&s->lock);
+  workRange(s, 0);
+  pthread_mutex_lock(&s->lock);
+  while (s->finished < s->n) pthread_cond_wait(&s->done, &s->lock);
+  s->branchOf = NULL;
+  pthread_mutex_unlock(&s->lock);
+  return 0;
+}
+
+#ifndef ASSIGN_LIBRARY     // bench.c and the other tools bring their own 
+/*************************************************************************/
+/* Daemon.  With --serve=SOCKET the program reads the input once, keeps it
+   and a solver with its threads, and answers requests on a Unix domain 
+   socket, one connection at a time.  A request is a line:
+
+     run N              the output of seed N, as the program gives it 
+                        once the input is read (the table files are 
+                        written too)
+     scan FIRST COUNT   the seeds of the range that the program would 
+                        report, as they are found; with "all" at the end
+                        every seed 
+     set FILE LENGTH    replaces the input FILE (Inst.csv, Shift.csv, 
+                        Pri.csv or Ind.csv) by the LENGTH bytes that 
+                        follow, for the rest of the connection
+     reset              back to the input read at the start
+     quit               closes the connection
+     shutdown           stops the daemon
+
+   Every answer ends with a line "end", or is a single line "ok" or 
+   "error ...".  An input longer than MAXTEXT, a line of the line buffer
+   for every shifter, is refused.  For instance: 
+   echo "scan 0 5000" | nc -U SOCKET */
+
+#define MAXTEXT (MAXIND*BUFFER)   // bytes of an input file at most 
+
+char *readText(char *name) {   // a whole input file, or NULL 
+  FILE *fp = fopen(name, "rb");
+  if (fp == NULL) return NULL;
+  fseek(fp, 0, SEEK_END);
+  long length = ftell(fp);
+  rewind(fp);
+  char *text = malloc(length + 1);
+  text[fread(text, 1, length, fp)] = '\0';
+  fclose(fp);
+  return text;
+}
+
+/*************************************************************************/
+void skipText(FILE *in, long length) {  // reads past a refused input 
+  char buffer[4096];
+  while (length > 0) {
+    size_t n = fread(buffer, 1, length < 4096 ? length : 4096, in);
+    if (n == 0) return;
+    length -= n;
+  }
+}
+
+/*************************************************************************/
+void serveScan(FILE *out, struct solver *solver, int first, int count, 
+               bool all) {
+
+  /* The seeds are solved in slices so the reports go out as they are 
+     found; the selection is the one of the scan in main */
+
+  int slice = 64*solver->nThreads;
+  struct result *results = calloc(slice, sizeof(struct result));
+  struct result runBest = {.seedIndex = -1};
+  for (int start = first; start < first + count; start += slice) {
+    int n = first + count - start < slice ? first + count - start : slice;
+    solveRange(solver, start, n, results);
+    for (int k = 0; k < n; k++) {
+      struct result *r = &results[k];
+      if (reportSeed(r, &runBest, NULL) || all || r->seedIndex % 10000 == 0)
+        put(out, "seed %d open = %d chisq = %d %d\n", r->seedIndex, 
+            r->openShifts, r->chisq, r->chisqInd);
+    }
+    teeFlush();
+  }
+  free(results);
+}
+
+/*************************************************************************/
+void serveRun(FILE *out, struct solver *solver, int seedIndex) {
+
+  /* As the program with a seed index, from the problem the solver keeps
+     rather than the files, with the log going to the connection */
+
+  FILE *saveConsole = console;
+  console = out;
+  engineType saveEngine = engine;
+  engine = solver->engine;
+  verbose = true;
+  solveProblem(solver->p, seedIndex);
+  shiftTable();
+  shifterTable();
+  institutionTable();
+  verbose = false;
+  engine = saveEngine;
+  console = saveConsole;
+}
+
+/*************************************************************************/
+bool serveConnection(int fd, struct solver *base, const char **baseTexts,
+                     const char *policy) {  // false for shutdown 
+
+  FILE *in = fdopen(fd, "r");
+  FILE *out = fdopen(dup(fd), "w");
+  const char *texts[4];
+  memcpy(texts, baseTexts, sizeof(texts));
+  struct problem *own = NULL;       // the problem with this input 
+  struct solver *solver = base;
+  bool shutdown = false;
+  char line[256];
+  while (fgets(line, sizeof(line), in)) {
+    char command[16] = "", name[32] = "", extra[16] = "";
+    int a = 0, b = 0;
+    sscanf(line, "%15s", command);
+    if (strcmp(command, "run") == 0 && sscanf(line, "%*s %d", &a) == 1 &&
+        a >= 0 && a < 1000000) {
+      serveRun(out, solver, a);
+      put(out, "end\n");
+    }
+    else if (strcmp(command, "scan") == 0 && 
+             sscanf(line, "%*s %d %d %15s", &a, &b, extra) >= 2 &&
+             a >= 0 && b >= 0 && a + b <= 1000000) {
+      serveScan(out, solver, a, b, strcmp(extra, "all") == 0);
+      put(out, "end\n");
+    }
+    else if (strcmp(command, "set") == 0 && 
+             sscanf(line, "%*s %31s %d", name, &a) == 2 && a >= 0) {
+      int which = 0;
+      while (which < 4 && strcmp(name, inputName[which])) which++;
+      char *text = a <= MAXTEXT ? malloc(a + 1) : NULL;
+      if (text) text[fread(text, 1, a, in)] = '\0';
+      else skipText(in, a);              // the next request is in step 
+      if (text == NULL && a > MAXTEXT) 
+        put(out, "error %s is over %d bytes\n", name, MAXTEXT);
+      else if (text == NULL) put(out, "error no memory for %s\n", name);
+      else if (which == 4) {
+        put(out, "error no input %s\n", name);
+        free(text);
+      }
+      else {
+        const char *old = texts[which];
+        texts[which] = text;
+        char error[256];
+        struct problem *p = parseProblem(texts[INST_FILE], 
+          texts[SHIFT_FILE], texts[PRI_FILE], texts[IND_FILE], policy, 
+          error, sizeof(error));
+        if (p == NULL) {                 // keep the input as it was 
+          char *reason = error + (error[0] == '\n');  // one line 
+          reason[strcspn(reason, "\n")] = '\0';
+          put(out, "error %s\n", reason);
+          texts[which] = old;
+          free(text);
+        }
+        else {
+          if (old != baseTexts[which]) free((char *)old);
+          if (own) {
+            freeSolver(solver);
+            freeProblem(own);
+          }
+          own = p;
+          solver = newSolver(own, base->nThreads);
+          solver->engine = base->engine;
+          put(out, "ok\n");
+        }
+      }
+    }
+    else if (strcmp(command, "reset") == 0) {
+      for (int which = 0; which < 4; which++) 
+        if (texts[which] != baseTexts[which]) free((char *)texts[which]);
+      memcpy(texts, baseTexts, sizeof(texts));
+      if (own) {
+        freeSolver(solver);
+        freeProblem(own);
+        own = NULL;
+        solver = base;
+      }
+      put(out, "ok\n");
+    }
+    else if (strcmp(command, "quit") == 0) break;
+    else if (strcmp(command, "shutdown") == 0) {
+      shutdown = true;
+      break;
+    }
+    else put(out, "error unknown request %s", line);
+    teeFlush();
+  }
+  for (int which = 0; which < 4; which++) 
+    if (texts[which] != baseTexts[which]) free((char *)texts[which]);
+  if (own) {
+    freeSolver(solver);
+    freeProblem(own);
+  }
+  teeClose(out);                     // after what was queued for it 
+  teeFlush();
+  fclose(in);
+  return ! shutdown;
+}
+
+/*************************************************************************/
+void serve(char *path, char *policy, int nThreads) {
+  const char *texts[4];
+  for (int which = 0; which < 4; which++) 
+    if ((texts[which] = readText((char *)inputName[which])) == NULL)
+      fatal(1, "\nCould not read %s.\n", inputName[which]);
+  if (strcmp(policy, "ask") == 0) policy = "fail";  // nobody to ask 
+  struct problem *problem = parseProblem(texts[INST_FILE], 
+    texts[SHIFT_FILE], texts[PRI_FILE], texts[IND_FILE], policy, NULL, 0);
+  struct solver *solver = newSolver(problem, nThreads);
+  solverReference(solver, engine == REFERENCE);
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if (listener < 0 || 
+      bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+      listen(listener, 8) < 0) 
+    fatal(1, "\nCould not listen on %s.\n", path);
+  signal(SIGPIPE, SIG_IGN);         // a client that leaves early 
+  tee(NULL, "Serving %s\n", path);
+  teeFlush();
+  while (true) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) continue;
+    if (! serveConnection(fd, solver, texts, policy)) break;
+  }
+  close(listener);
+  unlink(path);
+  freeSolver(solver);
+  freeProblem(problem);
+}
+
+/*************************************************************************/
+volatile sig_atomic_t stopRequested = 0;  // SIGINT or SIGTERM in a scan 
+
+void stopScan(int sig) {     /* the scan finishes the seeds it has begun
+                                and ends as usual */
+  (void)sig;
+  stopRequested = 1;
+}
+
+/*************************************************************************/
+void writeResults(char *fileName, struct result *best, int n, 
+                  double *weights, bool branches) {  /* the best seeds of a
+                                                        scan, as CSV */
+  FILE *fp = fopen(fileName, "w");
+  if (fp == NULL) fatal(1, "\nCould not write %s.\n", fileName);
+  put(fp, "rank,seed,openShifts,chisq,chisqInd%s%s\n", weights ? ",score" : "",
+      branches ? ",branch" : "");
+  for (int k = 0; k < n; k++) {
+    put(fp, "%d,%d,%d,%d,%d", k + 1, best[k].seedIndex, best[k].openShifts,
+        best[k].chisq, best[k].chisqInd);
+    if (weights) 
+      put(fp, ",%.9g", weights[0]*best[k].openShifts + 
+          weights[1]*best[k].chisq + weights[2]*best[k].chisqInd);
+    if (branches) put(fp, ",%d", best[k].branch);
+    put(fp, "\n");
+  }
+  teeClose(fp);
+}
+
+/*************************************************************************/
+/* Checkpoints.  With --checkpoint=FILE a scan saves where it is every 
+   --checkpoint-every seconds (default 60) and when it ends: the seeds 
+   done, the best seed reported so far, the K best seeds and the outcome
+   statistics, with the fingerprint of the input.  The seeds go out in 
+   order and a slice is finished by all the threads before the next, so
+   the seeds done are always 0 to one less than the next.  FILE is 
+   written beside and renamed, so a scan killed at any time leaves the 
+   last whole one.  With --resume a scan starts from FILE, if it is 
+   there, and appends to the log.  The file is text:
+
+     assign scan 1
+     fingerprint F            problemFingerprint of the input, in hex
+     seeds FIRST NEXT END     FIRST to NEXT - 1 of FIRST to END - 1 done
+     seconds S                time spent on them
+     order lex | order W1 W2 W3
+     report SEED OPEN CHISQ CHISQIND     the best reported; SEED -1 if none
+     top K N                  then N lines: SEED OPEN CHISQ CHISQIND
+     stats S                  S 1 if the statistics follow, as lines
+       metric M N MIN MAX SUM B BIN COUNT ...   M 0 to 2 as in outcomeName
+       inst I N MIN MAX SUM B BIN COUNT ...     I 1 to the institutions */
+
+struct scanState {
+  unsigned long long fingerprint;
+  int first, next, end;
+  double seconds;
+  bool weighted;
+  double weights[3];
+  struct result report;
+  int k, nBest;
+  struct result *best;     // room for k 
+  int savedK;              // the k of the file, by loadScan 
+  bool hasStats;
+  struct outcomeStats stats;
+  int nInst;
+};
+
+/*************************************************************************/
+void writeCounts(FILE *fp, const char *label, int index, 
+                 const struct moments *m, const long *count, int nBins) {
+  int used = 0;
+  for (int b = 0; b < nBins; b++) used += count[b] != 0;
+  fprintf(fp, "%s %d %ld %d %d %.17g %d", label, index, m->n, m->min, 
+          m->max, m->sum, used);
+  for (int b = 0; b < nBins; b++) 
+    if (count[b]) fprintf(fp, " %d %ld", b, count[b]);
+  fprintf(fp, "\n");
+}
+
+/*************************************************************************/
+bool readCounts(FILE *fp, const char *label, int index, struct moments *m,
+                long *count, int nBins) {
+  char word[16];
+  int at, used;
+  if (fscanf(fp, "%15s %d %ld %d %d %lf %d", word, &at, &m->n, &m->min, 
+             &m->max, &m->sum, &used) != 7 || strcmp(word, label) || 
+      at != index) return false;
+  for (int k = 0; k < used; k++) {
+    int b;
+    long c;
+    if (fscanf(fp, "%d %ld", &b, &c) != 2 || b < 0 || b >= nBins) 
+      return false;
+    count[b] = c;
+  }
+  return true;
+}
+
+/*************************************************************************/
+bool saveScan(const char *fileName, const struct scanState *st) {
+  char temp[1024];
+  snprintf(temp, sizeof(temp), "%s.new", fileName);
+  FILE *fp = fopen(temp, "w");
+  if (fp == NULL) return false;
+  fprintf(fp, "assign scan 1\nfingerprint %016llx\nseeds %d %d %d\n"
+          "seconds %.3f\n", st->fingerprint, st->first, st->next, st->end,
+          st->seconds);
+  if (st->weighted) fprintf(fp, "order %.17g %.17g %.17g\n", st->weights[0],
+                            st->weights[1], st->weights[2]);
+  else fprintf(fp, "order lex\n");
+  const struct result *r = &st->report;
+  fprintf(fp, "report %d %d %d %d\ntop %d %d\n", r->seedIndex, 
+          r->openShifts, r->chisq, r->chisqInd, st->k, st->nBest);
+  for (int k = 0; k < st->nBest; k++) 
+    fprintf(fp, "%d %d %d %d\n", st->best[k].seedIndex, 
+            st->best[k].openShifts, st->best[k].chisq, st->best[k].chisqInd);
+  fprintf(fp, "stats %d\n", st->hasStats);
+  if (st->hasStats) {
+    for (int k = 0; k < 3; k++) 
+      writeCounts(fp, "metric", k, &st->stats.metric[k].m, 
+                  st->stats.metric[k].count, NBINS);
+    for (int i = 1; i <= st->nInst; i++) 
+      writeCounts(fp, "inst", i, &st->stats.inst[i].m, 
+                  st->stats.inst[i].count, DEVBINS);
+  }
+  fflush(fp);
+  bool ok = fsync(fileno(fp)) == 0;  // on disk before it replaces the last
+  if (fclose(fp) != 0 || ! ok) return false;
+  return rename(temp, fileName) == 0;
+}
+
+/*************************************************************************/
+bool loadScan(const char *fileName, struct scanState *st) {
+
+  /* st comes with room for st->k best and for the statistics of 
+     st->nInst institutions, zeroed; false if the file is not whole */
+
+  FILE *fp = fopen(fileName, "r");
+  if (fp == NULL) return false;
+  int version, k = 0;
+  char order[32];
+  struct result *r = &st->report;
+  bool ok = fscanf(fp, "assign scan %d fingerprint %llx seeds %d %d %d "
+                   "seconds %lf order %31s", &version, &st->fingerprint, 
+                   &st->first, &st->next, &st->end, &st->seconds, 
+                   order) == 7 && version == 1;
+  st->weighted = ok && strcmp(order, "lex") != 0;
+  if (st->weighted) {
+    st->weights[0] = atof(order);
+    ok = fscanf(fp, "%lf %lf", &st->weights[1], &st->weights[2]) == 2;
+  }
+  int nFile = 0;
+  ok = ok && fscanf(fp, " report %d %d %d %d top %d %d", &r->seedIndex, 
+                    &r->openShifts, &r->chisq, &r->chisqInd, &k, 
+                    &nFile) == 6;
+  st->savedK = k;
+  st->nBest = 0;
+  for (int n = 0; ok && n < nFile; n++) {
+    struct result b = {0};
+    ok = fscanf(fp, "%d %d %d %d", &b.seedIndex, &b.openShifts, &b.chisq,
+                &b.chisqInd) == 4;
+    if (ok && st->nBest < st->k) st->best[st->nBest++] = b;  // the best 
+  }
+  int hasStats = 0;
+  ok = ok && fscanf(fp, " stats %d", &hasStats) == 1;
+  st->hasStats = hasStats;
+  for (int m = 0; ok && hasStats && m < 3; m++) 
+    ok = readCounts(fp, "metric", m, &st->stats.metric[m].m, 
+                    st->stats.metric[m].count, NBINS);
+  for (int i = 1; ok && hasStats && i <= st->nInst; i++) 
+    ok = readCounts(fp, "inst", i, &st->stats.inst[i].m, 
+                    st->stats.inst[i].count, DEVBINS);
+  fclose(fp);
+  return ok;
+}
+
+/*************************************************************************/
+void takeState(struct scanState *st, struct solver *s, int next, 
+               const struct result *report, double seconds) {  /* where the
+                                                                  scan is */
+  st->next = next;
+  st->report = *report;
+  st->seconds = seconds;
+  st->nBest = solverBest(s, st->best);
+  st->hasStats = s->stats != NULL;
+  if (st->hasStats) {
+    struct outcomeStats *all = solverMergedStats(s);
+    memcpy(st->stats.metric, all->metric, sizeof(all->metric));
+    memcpy(st->stats.inst, all->inst, 
+           (st->nInst + 1)*sizeof(struct deviation));
+  }
+}
+
+/*************************************************************************/
+void resumeState(struct scanState *st, struct solver *s) {
+
+  /* Puts the best seeds and the statistics of a checkpoint back into the 
+     lists of the first thread of the solver; the scan goes on from there */
+
+  for (int k = 0; k < st->nBest; k++) 
+    topAdd(&s->tops[0], &st->best[k], s->weighted ? s->weights : NULL);
+  if (st->hasStats && s->stats) {
+    statsMerge(&s->stats[0], &st->stats, st->nInst);
+    s->statsStarted -= st->seconds;
+  }
+}
+
+/*************************************************************************/
+/* Presolve report.  A scan starts with what the presolve of the fast 
+   engine found (see engines): how many of the requests can ever be 
+   granted at each LoP, the shifters who can take no shift at all, the 
+   shifts nobody can take, which stay open whatever the seed, and the 
+   institutions that asked for fewer points than their quota (see 
+   deficiencyReport), which cannot be filled whatever the seed. */
+
+void presolveReport(const struct problem *p) {
+  int asked1 = 0, asked2 = 0, kept1 = 0, kept2 = 0;
+  for (int is = 0; is < NSHIFTS; is++) {
+    kept1 += p->nAsked1[is];
+    kept2 += p->nAsked[is];
+  }
+  int idle = 0, barred = 0;
+  for (int ii = 0; ii < p->nInd; ii++) {
+    const struct individual *d = &p->ind[ii];
+    asked1 += d->nLoP1;
+    for (int is = 0; is < NSHIFTS; is++) asked2 += d->lop2[is];
+    if (d->request > 0 && d->nLoP1 > 0 && d->basePri <= 0.0) barred++;
+    bool any = false;
+    for (int is = 0; is < NSHIFTS && ! any; is++) 
+      for (int it = 0; it < p->nAsked[is] && ! any; it++) 
+        any = p->asked[is][it] == ii;
+    if (! any) idle++;
+  }
+  tee(fl, "Presolve: %d of %d requests can be granted at LoP-1, %d of %d "
+      "at LoP-2\n", kept1, asked1, kept2, asked2);
+  tee(fl, "%d shifters can take no shift, %d more are barred from LoP-1\n",
+      idle, barred);
+  for (int is = 0; is < NSHIFTS; is++) 
+    if (p->nAsked[is] == 0) 
+      tee(fl, "Shift %d %s %s: nobody can take it\n", is, 
+          p->shift[is].date, p->shift[is].type);
+  for (int i = 1; i <= p->nInst; i++) 
+    if (p->inst[i].nPRequested < p->inst[i].quota) 
+      tee(fl, "%s: %d points requested for a quota of %d\n", 
+          p->inst[i].name, p->inst[i].nPRequested, p->inst[i].quota);
+  tee(fl, "\n");
+}
+
+/*************************************************************************/
+/* Shards.  A scan can be cut into pieces that run anywhere, as separate
+   processes or on separate machines, with --shard=I/N (the I-th of N 
+   equal blocks of seeds, I from 0) or --seeds=FIRST-LAST.  The scan file
+   a piece leaves (see checkpoints) is its partial result: the input 
+   fingerprint, the seeds it covered, its K best seeds and its outcome 
+   statistics.  "assign merge FILE..." combines any number of them, with
+   the input in the current directory: the best seeds are ranked as one
+   scan ranks them, ties to the lower seed, so the result is the one a
+   single run over the same seeds gives.  The statistics add up, and the
+   seeds covered are checked for gaps and overlaps. */
+
+/*************************************************************************/
+void mergeScans(char **files, int nFiles, struct problem *problem, int topK,
+                double *weights, char *resultsFile, char *statusFile, 
+                char *stateFile) {
+  static struct deviation stateInst[MAXINST], allInst[MAXINST];
+  struct scanState st = {.fingerprint = problemFingerprint(problem), 
+    .weighted = weights != NULL, .k = topK};
+  if (weights) memcpy(st.weights, weights, sizeof(st.weights));
+  st.best = malloc(topK*sizeof(struct result));
+  st.stats.inst = stateInst;
+  st.nInst = problem->nInst;
+  static struct outcomeStats all;
+  all.inst = allInst;
+  struct result *best = malloc(topK*sizeof(struct result));
+  struct topList merged = {topK, 0, best};
+  int (*covered)[2] = malloc(nFiles*sizeof(*covered));
+  unsigned long long fingerprint = st.fingerprint;
+  double seconds = 0;
+  bool withStats = true;
+
+  for (int f = 0; f < nFiles; f++) {
+    memset(stateInst, 0, sizeof(stateInst));
+    memset(st.stats.metric, 0, sizeof(st.stats.metric));
+    if (! loadScan(files[f], &st)) 
+      fatal(1, "\n%s is not a scan file.\n", files[f]);
+    if (st.fingerprint != fingerprint) 
+      fatal(1, "\n%s is a scan of another input.\n", files[f]);
+    if (st.weighted != (weights != NULL) || (weights && 
+        memcmp(st.weights, weights, sizeof(st.weights))))
+      fatal(1, "\n%s ranks the seeds in another order.\n", files[f]);
+    if (st.nBest < topK && st.nBest < st.next - st.first) 
+      tee(fl, "%s kept only %d best seeds\n", files[f], st.nBest);
+    for (int k = 0; k < st.nBest; k++) topAdd(&merged, &st.best[k], weights);
+    withStats = withStats && st.hasStats;
+    if (st.hasStats) statsMerge(&all, &st.stats, problem->nInst);
+    seconds += st.seconds;
+    covered[f][0] = st.first;
+    covered[f][1] = st.next;
+    tee(fl, "%s: seeds %d to %d%s\n", files[f], st.first, st.next - 1,
+        st.next < st.end ? " (not finished)" : "");
+  }
+
+  // the seeds covered, in order: gaps are reported, overlaps are fatal
+
+  for (int f = 1; f < nFiles; f++)   // insertion sort by first seed 
+    for (int g = f; g > 0 && covered[g][0] < covered[g - 1][0]; g--) {
+      int t[2] = {covered[g][0], covered[g][1]};
+      memcpy(covered[g], covered[g - 1], sizeof(t));
+      memcpy(covered[g - 1], t, sizeof(t));
+    }
+  long nSeeds = 0;
+  for (int f = 0; f < nFiles; f++) {
+    nSeeds += covered[f][1] - covered[f][0];
+    if (f == 0) continue;
+    if (covered[f][0] < covered[f - 1][1]) 
+      fatal(1, "\nThe scans overlap at seed %d.\n", covered[f][0]);
+    if (covered[f][0] > covered[f - 1][1]) 
+      tee(fl, "Seeds %d to %d are missing\n", covered[f - 1][1], 
+          covered[f][0] - 1);
+  }
+  tee(fl, "\n%ld seeds merged from %d scans, %d to %d\n", nSeeds, nFiles,
+      nFiles ? covered[0][0] : 0, nFiles ? covered[nFiles - 1][1] - 1 : -1);
+  tee(fl, "\nBest %d seeds:\n", merged.n);
+  for (int k = 0; k < merged.n; k++) 
+    tee(fl, "seed %d open = %d chisq = %d %d\n", best[k].seedIndex, 
+        best[k].openShifts, best[k].chisq, best[k].chisqInd);
+  writeResults(resultsFile, best, merged.n, weights, false);
+  if (statusFile && ! withStats) 
+    tee(NULL, "\nSome scans have no statistics; no status file.\n");
+  else if (statusFile && 
+           writeStatus(statusFile, &all, problem, seconds) != 0) 
+    tee(NULL, "\nCould not write the status file %s.\n", statusFile);
+  if (stateFile) {                   // the merged scan, for a later merge 
+    if (nFiles && covered[nFiles - 1][1] - covered[0][0] != nSeeds) 
+      tee(NULL, "\nThe seeds are not contiguous; no merged scan file.\n");
+    else {
+      st.first = nFiles ? covered[0][0] : 0;
+      st.next = st.end = st.first + nSeeds;
+      st.seconds = seconds;
+      st.report = merged.n ? best[0] : (struct result){.seedIndex = -1};
+      st.nBest = merged.n;
+      memcpy(st.best, best, merged.n*sizeof(struct result));
+      st.hasStats = withStats;
+      st.stats = all;
+      if (! saveScan(stateFile, &st)) 
+        tee(NULL, "\nCould not write %s.\n", stateFile);
+    }
+  }
+  free(covered);
+  free(best);
+  free(st.best);
+}
+
+/*************************************************************************/
+/* Batch.  "assign batch SEEDS..." gives the full output of each seed, as
+   "assign SEED" does, in a directory of its own, Seed-NNNNNN, with the 
+   seeds run in the threads of -n.  SEEDS are seed indices, ranges 
+   FIRST-LAST, branches SEED/BRANCH (see branches) and results files of a
+   scan (TopSeeds.csv), whose seeds are taken in rank order.  A branch 
+   has the directory Seed-NNNNNN-BRANCH.  The log of each seed goes to the AssignLog.txt
+   of its directory only; the console gets the metrics of every seed, in
+   the order given. */
+
+struct batch {
+  int *seeds;              // seed index + 1000000*branch 
+  struct result *r;
+  int n;
+  int next;                // next seed to take 
+  pthread_mutex_t lock;
+};
+
+/*************************************************************************/
+int addSeed(int **seeds, int n, int seedIndex) {  /* in order; repeats go
+                                                     in uniqueSeeds */
+  if ((n & (n - 1)) == 0) *seeds = realloc(*seeds, 2*(n + 1)*sizeof(int));
+  (*seeds)[n] = seedIndex;
+  return n + 1;
+}
+
+/*************************************************************************/
+int compareJobs(const void *a, const void *b) {  // by seed, then place 
+  const int *x = a, *y = b;
+  if (x[0] != y[0]) return x[0] < y[0] ? -1 : 1;
+  return x[1] - y[1];
+}
+
+/*************************************************************************/
+int uniqueSeeds(int *seeds, int n) {  /* drops the repeats, the first of 
+                                         each stays where it is */
+  int (*job)[2] = malloc(n*sizeof(*job));     // seed and place 
+  bool *repeat = calloc(n, sizeof(bool));
+  for (int k = 0; k < n; k++) {
+    job[k][0] = seeds[k];
+    job[k][1] = k;
+  }
+  qsort(job, n, sizeof(*job), compareJobs);
+  for (int k = 1; k < n; k++) 
+    if (job[k][0] == job[k - 1][0]) repeat[job[k][1]] = true;
+  int m = 0;
+  for (int k = 0; k < n; k++) if (! repeat[k]) seeds[m++] = seeds[k];
+  free(job);
+  free(repeat);
+  return m;
+}
+
+/*************************************************************************/
+int readResults(const char *fileName, int **seeds, int n) {  /* adds the 
+                        seeds of the results file of a scan, in rank order */
+  FILE *fp = fopen(fileName, "r");
+  if (fp == NULL) fatal(1, "\nCould not read %s.\n", fileName);
+  char line[256];
+  int seedIndex;
+  bool branches = false;             // a last column of branches 
+  while (fgets(line, sizeof(line), fp)) {
+    if (strstr(line, ",branch")) branches = true;
+    if (sscanf(line, "%*d,%d", &seedIndex) == 1 && seedIndex >= 0 && 
+        seedIndex < 1000000) {
+      int b = branches ? atoi(strrchr(line, ',') + 1) : 0;
+      if (b >= 0 && b <= 2000) n = addSeed(seeds, n, seedIndex + 1000000*b);
+    }
+  }
+  fclose(fp);
+  return n;
+}
+
+/*************************************************************************/
+int batchSeeds(char **args, int nArgs, int **seeds) {  /* the seeds of the 
+                                                          arguments */
+  int n = 0;
+  *seeds = NULL;
+  for (int a = 0; a < nArgs; a++) {
+    int first, last;
+    char end;
+    int b;
+    if (sscanf(args[a], "%d/%d%c", &first, &b, &end) == 2) {
+      if (first < 0 || first > 999999 || b < 0 || b > 2000) 
+        fatal(1, "\nThe branch %s is not a seed within 0 to 999999 and a "
+              "branch within 0 to 2000.\n", args[a]);
+      n = addSeed(seeds, n, first + 1000000*b);
+      continue;
+    }
+    bool range = sscanf(args[a], "%d-%d%c", &first, &last, &end) == 2;
+    if (! range && sscanf(args[a], "%d%c", &first, &end) == 1) {
+      last = first;
+      range = true;
+    }
+    if (range) {
+      if (first < 0 || last < first || last > 999999) 
+        fatal(1, "\nThe seeds %s are not within 0 to 999999.\n", args[a]);
+      for (int seedIndex = first; seedIndex <= last; seedIndex++) 
+        n = addSeed(seeds, n, seedIndex);
+      continue;
+    }
+    n = readResults(args[a], seeds, n);    // the results of a scan 
+  }
+  if (n == 0) fatal(1, "\nThere are no seeds to run.\n");
+  return uniqueSeeds(*seeds, n);
+}
+
+/*************************************************************************/
+void seedDir(int job, char *dir, int size) {  // the directory of a batch seed 
+  if (job < 1000000) snprintf(dir, size, "Seed-%06d", job);
+  else snprintf(dir, size, "Seed-%06d-%d", job%1000000, job/1000000);
+}
+
+/*************************************************************************/
+void batchSeed(int job, struct result *r) {  /* the full output of a seed 
+                                                in its directory */
+  char dir[32];
+  seedDir(job, dir, sizeof(dir));
+  mkdir(dir, 0777);                  // may be there already 
+  outputDir = dir;
+  double started = now();
+  fl = openOutput("AssignLog.txt");
+  verbose = true;
+  branch = job/1000000;
+  solveSeed(job%1000000);
+  shiftTable();
+  shifterTable();
+  institutionTable();
+  verbose = false;
+  takeResult(job%1000000, r);
+  branch = 0;
+  r->seconds = now() - started;
+  teeClose(fl);
+  teeFlush();                        // its output goes out as it is done 
+  outputDir = ".";
+}
+
+/*************************************************************************/
+void *batchThread(void *arg) {
+  struct batch *b = arg;
+  quiet = true;                      // the console is the main thread's 
+  pthread_mutex_lock(&b->lock);
+  while (b->next < b->n) {
+    int k = b->next++;
+    pthread_mutex_unlock(&b->lock);
+    batchSeed(b->seeds[k], &b->r[k]);
+    pthread_mutex_lock(&b->lock);
+  }
+  pthread_mutex_unlock(&b->lock);
+  teeFlush();
+  free(current);                     // the fresh chunk teeFlush left 
+  current = NULL;
+  return NULL;
+}
+
+/*************************************************************************/
+void runBatch(char **args, int nArgs, int nThreads) {
+  struct batch b = {NULL, NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+  b.n = batchSeeds(args, nArgs, &b.seeds);
+  b.r = calloc(b.n, sizeof(struct result));
+  if (nThreads > b.n) nThreads = b.n;
+  if (nThreads < 1) nThreads = 1;
+  tee(fl, "Full output of %d seeds in %d threads\n\n", b.n, nThreads);
+  teeFlush();
+  double started = now();
+  pthread_t *threads = malloc(nThreads*sizeof(pthread_t));
+  for (int t = 0; t < nThreads; t++) 
+    startThread(&threads[t], batchThread, &b);
+  for (int t = 0; t < nThreads; t++) pthread_join(threads[t], NULL);
+  struct result best = {.seedIndex = -1};
+  char dir[32];
+  for (int k = 0; k < b.n; k++) {
+    seedDir(b.seeds[k], dir, sizeof(dir));
+    tee(fl, "seed %d", b.r[k].seedIndex);
+    if (b.r[k].branch) tee(fl, "/%d", b.r[k].branch);
+    tee(fl, " open = %d chisq = %d %d  in %s\n", b.r[k].openShifts, 
+        b.r[k].chisq, b.r[k].chisqInd, dir);
+    if (best.seedIndex < 0 || better(&b.r[k], &best, NULL)) best = b.r[k];
+  }
+  tee(fl, "\n%d seeds in %.1f s; the best is seed %d", b.n, 
+      now() - started, best.seedIndex);
+  if (best.branch) tee(fl, "/%d", best.branch);
+  tee(fl, "\n");
+  free(threads);
+  free(b.r);
+  free(b.seeds);
+}
+
+/*************************************************************************/
+/* Sweep.  "assign sweep FILE" scans the seeds of the input and of 
+   variations of it, and compares their outcomes in a table.  Each line
+   of FILE is a variation: a name, then changes, each
+
+     quota INSTITUTION VALUE     the quota of an institution of Inst.csv
+     request SHIFTER VALUE       the points a shifter (ECLID or name) asks
+
+   where VALUE is a number, +N or -N for a change from the input, or a
+   range FIRST..LAST of either kind, which makes a variation of each 
+   value; several ranges make the grid of them.  # starts a comment.  A
+   variation is a copy of the parsed input with the changes made (see 
+   copyProblem), so nothing is read again, and its seeds are the seeds of
+   the scan (--seeds, --max-seeds) run in the threads of -n.  The input 
+   as it is comes first.  The table, best seed and mean outcomes of each,
+   is written to the results file as well (default Sweep.csv). */
+
+#define MAXCHANGES 8       // changes on a line of a sweep file 
+
+struct change {
+  bool quota;              // else request 
+  char who[80];
+  bool relative;           // FIRST and LAST are changes from the input 
+  int first, last;
+  int value;               // the current one 
+};
+
+/*************************************************************************/
+void sweepVariant(const char *name, struct change *changes, int nChanges,
+                  struct problem *base, int first, int endSeed, 
+                  int nThreads, FILE *fc) {
+
+  /* Scans one variation and adds its line to the table */
+
+  struct problem *p = copyProblem(base);
+  char text[1024] = "";
+  int at = 0;
+  for (int c = 0; c < nChanges && at < (int)sizeof(text); c++) {
+    struct change *ch = &changes[c];
+    int value = ch->value;
+    int i = ch->quota ? findInstitution(base, ch->who) 
+                      : findShifter(base, ch->who);
+    if (i < 0) fatal(1, "\nThere is no %s %s (%s).\n", 
+                     ch->quota ? "institution" : "shifter", ch->who, name);
+    if (ch->relative)                // a change from the input 
+      value += ch->quota ? base->inst[i].quota : base->ind[i].request;
+    if ((ch->quota ? setQuota(p, ch->who, value) 
+                   : setRequest(p, ch->who, value)) < 0) 
+      fatal(1, "\nThe %s of %s cannot be %d (%s).\n", 
+            ch->quota ? "quota" : "request", ch->who, value, name);
+    at += snprintf(text + at, sizeof(text) - at, "%s%s %s %d", 
+                   c ? "; " : "", ch->quota ? "quota" : "request", ch->who,
+                   value);
+  }
+
+  struct solver *solver = newSolver(p, nThreads);
+  solverReference(solver, engine == REFERENCE);
+  solverTop(solver, 1, NULL);
+  int slice = 64*nThreads;
+  struct result *results = calloc(slice, sizeof(struct result));
+  double sumOpen = 0, sumChisq = 0, sumChisqInd = 0;
+  for (int next = first; next < endSeed; next += slice) {
+    int n = endSeed - next < slice ? endSeed - next : slice;
+    solveRange(solver, next, n, results);
+    for (int k = 0; k < n; k++) {
+      sumOpen += results[k].openShifts;
+      sumChisq += results[k].chisq;
+      sumChisqInd += results[k].chisqInd;
+    }
+  }
+  struct result best = {.seedIndex = -1};
+  solverBest(solver, &best);
+  int nSeeds = endSeed - first;
+  tee(fl, "%-20s %7d %5d %6d %8d %8.2f %8.2f %10.1f  %s\n", name, 
+      best.seedIndex, best.openShifts, best.chisq, best.chisqInd, 
+      sumOpen/nSeeds, sumChisq/nSeeds, sumChisqInd/nSeeds, text);
+  teeFlush();
+  put(fc, "\"%s\",\"%s\",%d,%d,%d,%d,%d,%.6g,%.6g,%.6g\n", name, text, 
+      nSeeds, best.seedIndex, best.openShifts, best.chisq, best.chisqInd,
+      sumOpen/nSeeds, sumChisq/nSeeds, sumChisqInd/nSeeds);
+  free(results);
+  freeSolver(solver);
+  freeProblem(p);
+}
+
+/*************************************************************************/
+void runSweep(const char *fileName, struct problem *base, int first, 
+              int endSeed, int nThreads, char *resultsFile) {
+  FILE *fp = fopen(fileName, "r");
+  if (fp == NULL) fatal(1, "\nCould not read %s.\n", fileName);
+  FILE *fc = fopen(resultsFile, "w");
+  if (fc == NULL) fatal(1, "\nCould not write %s.\n", resultsFile);
+  tee(fl, "Sweep of %s, seeds %d to %d\n\n", fileName, first, endSeed - 1);
+  tee(fl, "%-20s %7s %5s %6s %8s %8s %8s %10s  %s\n", "variation", "best",
+      "open", "chisq", "chisqInd", "mean", "chisq", "chisqInd", "changes");
+  put(fc, "variation,changes,seeds,best,openShifts,chisq,chisqInd,"
+      "meanOpenShifts,meanChisq,meanChisqInd\n");
+  double started = now();
+  sweepVariant("input", NULL, 0, base, first, endSeed, nThreads, fc);
+
+  char line[1024];
+  int lineNumber = 0;
+  int nVariants = 1;
+  while (fgets(line, sizeof(line), fp)) {
+    lineNumber++;
+    line[strcspn(line, "#\r\n")] = '\0';
+    char *name = strtok(line, " \t");
+    if (name == NULL) continue;
+    struct change changes[MAXCHANGES];
+    int nChanges = 0;
+    char *kind;
+    while ((kind = strtok(NULL, " \t"))) {
+      char *who = strtok(NULL, " \t");
+      char *value = strtok(NULL, " \t");
+      struct change *ch = &changes[nChanges];
+      if (value == NULL || nChanges == MAXCHANGES || 
+          (strcmp(kind, "quota") && strcmp(kind, "request")) ||
+          strlen(who) >= sizeof(ch->who)) 
+        fatal(1, "\nLine %d of %s is not NAME followed by quota or request"
+              " changes.\n", lineNumber, fileName);
+      ch->quota = strcmp(kind, "quota") == 0;
+      strcpy(ch->who, who);
+      ch->relative = value[0] == '+' || value[0] == '-';
+      int n = sscanf(value, "%d..%d", &ch->first, &ch->last);
+      if (n == 1) ch->last = ch->first;
+      if (n < 1 || ch->last < ch->first) 
+        fatal(1, "\nLine %d of %s has the value %s.\n", lineNumber, 
+              fileName, value);
+      ch->value = ch->first;
+      nChanges++;
+    }
+
+    while (true) {                   // every point of the grid 
+      char variant[96];
+      snprintf(variant, sizeof(variant), "%s", name);
+      for (int c = 0; c < nChanges; c++) 
+        if (changes[c].last > changes[c].first) {
+          int at = strlen(variant);
+          snprintf(variant + at, sizeof(variant) - at, 
+                   changes[c].relative ? "%s%+d" : "%s%d", 
+                   at > (int)strlen(name) ? "," : ":", changes[c].value);
+        }
+      sweepVariant(variant, changes, nChanges, base, first, endSeed, 
+                   nThreads, fc);
+      nVariants++;
+      int c = 0;                     // the next one 
+      while (c < nChanges && changes[c].value == changes[c].last) {
+        changes[c].value = changes[c].first;
+        c++;
+      }
+      if (c == nChanges) break;
+      changes[c].value++;
+    }
+  }
+  fclose(fp);
+  teeClose(fc);
+  tee(fl, "\n%d variations of %d seeds in %.1f s\n", nVariants, 
+      endSeed - first, now() - started);
+}
+
+/*************************************************************************/
+/* Sensitivity.  "assign sensitivity SEEDS..." solves each seed again with
+   one shifter changed at a time, for every shifter who asks for points,
+   and reports how the outcome moves.  The changes are
+
+     remove      the shifter asks for no points, as if gone (the others 
+                 draw the same random priorities)
+     strict      a consecutive shift is no longer required
+     rest        8 hours of rest are enough
+     nonConsec   no break between shifts is asked
+
+   each only where it is a change.  SEEDS are as for batch.  The input is
+   read once; each thread of -n keeps a copy of it and undoes a change 
+   after its seed.  Every change goes to the results file (default 
+   Sensitivity.csv) with its outcome, the differences from the seed 
+   itself and the shifts that went to someone else; the log lists, for 
+   each seed, the changes that moved the most shifts. */
+
+typedef enum {SN_REMOVE, SN_STRICT, SN_REST, SN_NONCONSEC, 
+              NSENSITIVITY} sensitivityType;
+const char *sensitivityName[NSENSITIVITY] = {"remove", "strict", "rest", 
+                                             "nonConsec"};
+
+struct sensitivity {
+  const struct problem *p;
+  int *seeds;              // seed index + 1000000*branch, as batch 
+  int nSeeds;
+  struct result *base;     // each seed itself, its shifts included 
+  struct result *r;        // of each change, nSeeds*nInd*NSENSITIVITY 
+  int *moved;              // shifts that went to someone else 
+  bool changes;            // the changes, after the seeds themselves 
+  int n;
+  int next;                // next to take 
+  pthread_mutex_t lock;
+};
+
+/*************************************************************************/
+bool sensitivityApplies(const struct individual *d, sensitivityType t) {
+  if (d->request <= 0) return false;
+  switch (t) {
+  case SN_REMOVE : return true;
+  case SN_STRICT : return d->consec == YES && d->strict == STRICT;
+  case SN_REST : return d->consec == YES && d->rest != SHORT_REST;
+  case SN_NONCONSEC : return d->nonConsec > 1;
+  default : return false;
+  }
+}
+
+/*************************************************************************/
+int sensitivityChange(struct problem *q, int ii, sensitivityType t, 
+                      int value) {  /* sets the field the change is about to
+                                       value and returns the old one */
+  struct individual *d = &q->ind[ii];
+  int old;
+  switch (t) {
+  case SN_REMOVE : return setRequestOf(q, ii, value);
+  case SN_STRICT : old = d->strict; d->strict = value; return old;
+  case SN_REST : old = d->rest; d->rest = value; return old;
+  default : old = d->nonConsec; d->nonConsec = value; return old;
+  }
+}
+
+/*************************************************************************/
+void *sensitivityThread(void *arg) {
+  struct sensitivity *sv = arg;
+  struct problem *q = copyProblem(sv->p);     // this thread's to change 
+  int *assigned = malloc(NSHIFTS*sizeof(int));
+  const int relaxed[NSENSITIVITY] = {0, NOT_STRICT, SHORT_REST, 1};
+  int perSeed = q->nInd*NSENSITIVITY;
+  pthread_mutex_lock(&sv->lock);
+  while (sv->next < sv->n) {
+    int k = sv->next++;
+    pthread_mutex_unlock(&sv->lock);
+    int job = sv->changes ? sv->seeds[k/perSeed] : sv->seeds[k];
+    struct result *r = sv->changes ? &sv->r[k] : &sv->base[k];
+    int ii = k%perSeed/NSENSITIVITY;
+    sensitivityType t = k%NSENSITIVITY;
+    if (sv->changes && ! sensitivityApplies(&q->ind[ii], t)) 
+      r->seedIndex = -1;                      // nothing to change 
+    else {
+      int old = sv->changes ? sensitivityChange(q, ii, t, relaxed[t]) : 0;
+      if (sv->changes) r->assigned = assigned;
+      branch = job/1000000;
+      solveProblem(q, job%1000000);
+      takeResult(job%1000000, r);
+      branch = 0;
+      if (sv->changes) {
+        sensitivityChange(q, ii, t, old);
+        const int *before = sv->base[k/perSeed].assigned;
+        sv->moved[k] = 0;
+        for (int is = 0; is < NSHIFTS; is++) 
+          sv->moved[k] += assigned[is] != before[is];
+        r->assigned = NULL;
+      }
+    }
+    pthread_mutex_lock(&sv->lock);
+  }
+  pthread_mutex_unlock(&sv->lock);
+  free(assigned);
+  freeProblem(q);
+  return NULL;
+}
+
+/*************************************************************************/
+void sensitivityRun(struct sensitivity *sv, bool changes, int n, 
+                    int nThreads) {  // the seeds or the changes, in threads 
+  sv->changes = changes;
+  sv->n = n;
+  sv->next = 0;
+  if (nThreads > n) nThreads = n;
+  if (nThreads < 1) nThreads = 1;
+  pthread_t *threads = malloc(nThreads*sizeof(pthread_t));
+  for (int t = 0; t < nThreads; t++) 
+    startThread(&threads[t], sensitivityThread, sv);
+  for (int t = 0; t < nThreads; t++) pthread_join(threads[t], NULL);
+  free(threads);
+}
+
+/*************************************************************************/
+void runSensitivity(char **args, int nArgs, const struct problem *p, 
+                    int nThreads, char *resultsFile) {
+  struct sensitivity sv = {.p = p};
+  pthread_mutex_init(&sv.lock, NULL);
+  sv.nSeeds = batchSeeds(args, nArgs, &sv.seeds);
+  int perSeed = p->nInd*NSENSITIVITY;
+  sv.base = calloc(sv.nSeeds, sizeof(struct result));
+  for (int k = 0; k < sv.nSeeds; k++) 
+    sv.base[k].assigned = malloc(NSHIFTS*sizeof(int));
+  sv.r = calloc(sv.nSeeds*perSeed, sizeof(struct result));
+  sv.moved = calloc(sv.nSeeds*perSeed, sizeof(int));
+  FILE *fc = fopen(resultsFile, "w");
+  if (fc == NULL) fatal(1, "\nCould not write %s.\n", resultsFile);
+  double started = now();
+  sensitivityRun(&sv, false, sv.nSeeds, nThreads);
+  sensitivityRun(&sv, true, sv.nSeeds*perSeed, nThreads);
+
+  put(fc, "seed,branch,change,shifter,institution,openShifts,chisq,"
+      "chisqInd,dOpenShifts,dChisq,dChisqInd,moved\n");
+  int nChanges = 0;
+  for (int k = 0; k < sv.nSeeds; k++) {
+    const struct result *b = &sv.base[k];
+    tee(fl, "\nseed %d", b->seedIndex);
+    if (b->branch) tee(fl, "/%d", b->branch);
+    tee(fl, " open = %d chisq = %d %d\n", b->openShifts, b->chisq, 
+        b->chisqInd);
+    int order[10];                 // the changes that moved the most 
+    int nOrder = 0, nBetter = 0, nWorse = 0;
+    for (int c = k*perSeed; c < (k + 1)*perSeed; c++) {
+      const struct result *r = &sv.r[c];
+      if (r->seedIndex < 0) continue;
+      nChanges++;
+      nBetter += better(r, b, NULL);
+      nWorse += better(b, r, NULL);
+      const struct individual *d = &p->ind[c%perSeed/NSENSITIVITY];
+      put(fc, "%d,%d,%s,%s,%s,%d,%d,%d,%d,%d,%d,%d\n", b->seedIndex, 
+          b->branch, sensitivityName[c%NSENSITIVITY], d->ECLID, 
+          p->inst[d->home].name, r->openShifts, r->chisq, r->chisqInd, 
+          r->openShifts - b->openShifts, r->chisq - b->chisq, 
+          r->chisqInd - b->chisqInd, sv.moved[c]);
+      if (sv.moved[c] == 0) continue;
+      int at = nOrder < 10 ? nOrder++ : 10;
+      while (at > 0 && sv.moved[order[at - 1]] < sv.moved[c]) {
+        if (at < 10) order[at] = order[at - 1];
+        at--;
+      }
+      if (at < 10) order[at] = c;
+    }
+    tee(fl, "%d changes make it better, %d worse; the ones that move the "
+        "most shifts:\n", nBetter, nWorse);
+    for (int o = 0; o < nOrder; o++) {
+      int c = order[o];
+      const struct result *r = &sv.r[c];
+      const struct individual *d = &p->ind[c%perSeed/NSENSITIVITY];
+      tee(fl, "  %-9s %-20s %-8s moved %3d  open %+d chisq %+d %+d\n", 
+          sensitivityName[c%NSENSITIVITY], d->name, p->inst[d->home].name,
+          sv.moved[c], r->openShifts - b->openShifts, r->chisq - b->chisq,
+          r->chisqInd - b->chisqInd);
+    }
+  }
+  teeClose(fc);
+  tee(fl, "\n%d changes of %d seeds in %.1f s\n", nChanges, sv.nSeeds, 
+      now() - started);
+  for (int k = 0; k < sv.nSeeds; k++) free(sv.base[k].assigned);
+  free(sv.base);
+  free(sv.r);
+  free(sv.moved);
+  free(sv.seeds);
+  pthread_mutex_destroy(&sv.lock);
+}
+
+/*************************************************************************/
+/* Tuning.  --param NAME=VALUE sets a constant of the heuristic (see 
+   tuning above for the names), and --param FILE reads NAME=VALUE lines
+   from FILE.  "assign tune DIR..." searches for constants that find good
+   seeds early, on the inputs in each DIR (the current directory if 
+   none), by successive halving: --candidates sets of constants (default
+   32), the ones in effect first and the others drawn at random within 
+   the bounds of tuningLow and tuningHigh, are each scored on the first 
+   64 seeds; the better half goes on to twice as many seeds, and so on 
+   until one is left or the seeds reach --max-seeds.  Every set runs the
+   same seeds.  The score of a set is its best seed on each input, summed
+   over the inputs as |open|, chisq and chisqInd and ranked as a scan 
+   ranks seeds (--order).  The winner is written as NAME=VALUE lines to 
+   the results file (default Tuned.txt), ready for --param. */
+
+#define MAXTUNE 16         // inputs of a tuning 
+
+struct candidate {
+  double value[NTUNING];
+  struct result best[MAXTUNE];    // the best seed so far on each input 
+  struct result score;            // their sums 
+  int seeds;                      // seeds the score is over 
+};
+
+/*************************************************************************/
+bool setParam(const char *text) {  /* NAME=VALUE, or a file of them; false
+                                      if unknown */
+  const char *equal = strchr(text, '=');
+  if (equal == NULL) {
+    FILE *fp = fopen(text, "r");
+    if (fp == NULL) return false;
+    char line[256];
+    bool ok = true;
+    while (fgets(line, sizeof(line), fp) && ok) {
+      line[strcspn(line, "#\r\n")] = '\0';
+      if (strspn(line, " \t") < strlen(line)) ok = setParam(line);
+    }
+    fclose(fp);
+    return ok;
+  }
+  for (int t = 0; t < NTUNING; t++) 
+    if (strncmp(text, tuningName[t], equal - text) == 0 && 
+        tuningName[t][equal - text] == '\0') {
+      char *end;
+      tuning[t] = strtod(equal + 1, &end);
+      return end > equal + 1;
+    }
+  return false;
+}
+
+/*************************************************************************/
+void scoreCandidate(struct candidate *c, struct solver **solvers, 
+                    int nInputs, int first, int end, double *weights) {
+  int slice = 64*solvers[0]->nThreads;
+  struct result *results = calloc(slice, sizeof(struct result));
+  memcpy(tuning, c->value, sizeof(tuning));
+  for (int in = 0; in < nInputs; in++) 
+    for (int next = first; next < end; next += slice) {
+      int n = end - next < slice ? end - next : slice;
+      solveRange(solvers[in], next, n, results);
+      for (int k = 0; k < n; k++) 
+        if (c->best[in].seedIndex < 0 || 
+            better(&results[k], &c->best[in], weights)) 
+          c->best[in] = results[k];
+    }
+  struct result score = {0};
+  for (int in = 0; in < nInputs; in++) {
+    score.openShifts += abs(c->best[in].openShifts);
+    score.chisq += c->best[in].chisq;
+    score.chisqInd += c->best[in].chisqInd;
+  }
+  c->score = score;
+  c->seeds = end;
+  free(results);
+}
+
+/*************************************************************************/
+void tuneLine(int rank, struct candidate *c) {
+  tee(fl, "%4d %5d %6d %8d ", rank, c->score.openShifts, c->score.chisq,
+      c->score.chisqInd);
+  for (int t = 0; t < NTUNING; t++) tee(fl, " %s=%g", tuningName[t], 
+                                        c->value[t]);
+  tee(fl, "\n");
+}
+
+/*************************************************************************/
+void runTune(char **dirs, int nDirs, const char *policy, int nCandidates,
+             int maxSeeds, int nThreads, double *weights, char *resultsFile) {
+  char *here = ".";
+  if (nDirs == 0) {
+    dirs = &here;
+    nDirs = 1;
+  }
+  if (nDirs > MAXTUNE) fatal(1, "\nAt most %d inputs can be tuned on.\n", 
+                             MAXTUNE);
+  if (nCandidates < 1) nCandidates = 1;
+  struct problem *problems[MAXTUNE];
+  struct solver *solvers[MAXTUNE];
+  for (int in = 0; in < nDirs; in++) {
+    problems[in] = loadProblem(dirs[in], policy, NULL, 0);
+    solvers[in] = newSolver(problems[in], nThreads);
+    solverReference(solvers[in], engine == REFERENCE);
+  }
+
+  double saved[NTUNING];
+  memcpy(saved, tuning, sizeof(tuning));
+  struct candidate *all = calloc(nCandidates, sizeof(struct candidate));
+  struct candidate **alive = malloc(nCandidates*sizeof(struct candidate *));
+  unsigned long long state = 0x9e3779b97f4a7c15ULL;  // draws of the sets 
+  for (int k = 0; k < nCandidates; k++) {
+    for (int t = 0; t < NTUNING; t++) {
+      state = state*6364136223846793005ULL + 1442695040888963407ULL;
+      double u = (state >> 11)*(1.0/9007199254740992.0);
+      double v = tuningLow[t] + u*(tuningHigh[t] - tuningLow[t]);
+      all[k].value[t] = k == 0 ? tuning[t] 
+                               : tuningInteger[t] ? (int)(v + 0.5) : v;
+    }
+    for (int in = 0; in < MAXTUNE; in++) all[k].best[in].seedIndex = -1;
+    alive[k] = &all[k];
+  }
+
+  tee(fl, "Tuning on %d inputs, %d sets of constants\n", nDirs, nCandidates);
+  double started = now();
+  int nAlive = nCandidates;
+  int done = 0;
+  int budget = 64 < maxSeeds ? 64 : maxSeeds;
+  while (true) {
+    for (int k = 0; k < nAlive; k++) 
+      scoreCandidate(alive[k], solvers, nDirs, done, budget, weights);
+    for (int k = 1; k < nAlive; k++) {    // best first, stable 
+      struct candidate *c = alive[k];
+      int at = k;
+      while (at > 0 && better(&c->score, &alive[at - 1]->score, weights)) {
+        alive[at] = alive[at - 1];
+        at--;
+      }
+      alive[at] = c;
+    }
+    tee(fl, "\n%d sets on seeds 0 to %d, %.1f s:\n", nAlive, budget - 1,
+        now() - started);
+    tee(fl, "rank  open  chisq chisqInd  constants\n");
+    for (int k = 0; k < nAlive; k++) tuneLine(k + 1, alive[k]);
+    teeFlush();
+    if (nAlive == 1 || budget >= maxSeeds || stopRequested) break;
+    nAlive = (nAlive + 1)/2;
+    if (nAlive == 1) break;
+    done = budget;
+    budget = 2*budget < maxSeeds ? 2*budget : maxSeeds;
+  }
+
+  struct candidate *winner = alive[0];
+  tee(fl, "\nThe best constants, over seeds 0 to %d:\n", winner->seeds - 1);
+  tuneLine(1, winner);
+  tee(fl, "The constants in effect before, over seeds 0 to %d:\n", 
+      all[0].seeds - 1);
+  tuneLine(1, &all[0]);
+  FILE *fp = fopen(resultsFile, "w");
+  if (fp == NULL) fatal(1, "\nCould not write %s.\n", resultsFile);
+  for (int t = 0; t < NTUNING; t++) 
+    put(fp, "%s=%.17g\n", tuningName[t], winner->value[t]);
+  teeClose(fp);
+
+  memcpy(tuning, saved, sizeof(tuning));
+  for (int in = 0; in < nDirs; in++) {
+    freeSolver(solvers[in]);
+    freeProblem(problems[in]);
+  }
+  free(alive);
+  free(all);
+}
+
+/*************************************************************************/
+/* Warm start.  With --warm=DIR the program starts from an earlier run in
+   DIR, its 4 input files and the results file of its scan (TopSeeds.csv),
+   after late changes to the input in the current directory:
+
+     the changes are listed: shifters (matched by ECL ID), shifts, and
+       institutions (matched by name) that differ;
+     each seed of the results file is repaired: run on the old input, it
+       keeps the shifts it gave to shifters who did not change, where the
+       shift did not change either, and the algorithm fills in the others
+       with the same seed on the new input;
+     each of them also runs again from scratch on the new input.
+
+   The best of all, in the order of -o, gets the full output, as for a 
+   seed index; at equal metrics a seed's repaired assignment wins over 
+   its new run, as it moves the fewest shifts.  This repairs the seeds the
+   earlier scan kept; it is not an incremental re-solve, its cost is 3 
+   runs of each of them whatever the change, and a full scan is still the
+   reference. */
+
+/*************************************************************************/
+bool sameShifter(const struct individual *a, const struct problem *pa,
+                 const struct individual *b, const struct problem *pb) {
+  return strcmp(pa->inst[a->home].name, pb->inst[b->home].name) == 0 &&
+    a->request == b->request && a->over == b->over && 
+    a->consec == b->consec && a->rest == b->rest && 
+    a->strict == b->strict && a->nonConsec == b->nonConsec && 
+    a->basePri == b->basePri && 
+    memcmp(a->lop1, b->lop1, sizeof(a->lop1)) == 0 &&
+    memcmp(a->lop2, b->lop2, sizeof(a->lop2)) == 0;
+}
+
+/*************************************************************************/
+int diffProblems(const struct problem *old, const struct problem *p,
+                 int *oldToNew, bool *changedInd, bool *changedShift) {
+
+  /* Lists the changes from old to p and returns their number.  oldToNew
+     maps the shifters of old to those of p (-1 if gone); changedInd and
+     changedShift flag what differs in p. */
+
+  int nChanges = 0;
+  for (int io = 0; io < old->nInd; io++) oldToNew[io] = -1;
+  for (int ii = 0; ii < p->nInd; ii++) {
+    const struct individual *b = &p->ind[ii];
+    int io = 0;
+    while (io < old->nInd && strcmp(old->ind[io].ECLID, b->ECLID)) io++;
+    changedInd[ii] = true;
+    if (io == old->nInd) 
+      tee(fl, "  shifter %s (%s) is new\n", b->name, b->ECLID);
+    else {
+      oldToNew[io] = ii;
+      changedInd[ii] = ! sameShifter(&old->ind[io], old, b, p);
+      if (changedInd[ii])
+        tee(fl, "  shifter %s (%s) changed\n", b->name, b->ECLID);
+    }
+    nChanges += changedInd[ii];
+  }
+  for (int io = 0; io < old->nInd; io++) 
+    if (oldToNew[io] < 0) {
+      tee(fl, "  shifter %s (%s) is gone\n", old->ind[io].name, 
+          old->ind[io].ECLID);
+      nChanges++;
+    }
+  for (int is = 0; is < NSHIFTS; is++) {
+    const struct shifts *a = &old->shift[is], *b = &p->shift[is];
+    changedShift[is] = a->points != b->points || a->stype != b->stype ||
+      strcmp(a->date, b->date) || strcmp(a->type, b->type);
+    if (changedShift[is]) {
+      tee(fl, "  shift %d %s %s changed\n", is, b->date, b->type);
+      nChanges++;
+    }
+  }
+  for (int i = 1; i <= p->nInst; i++) {  // quotas move the priorities only
+    int io = 1;
+    while (io <= old->nInst && strcmp(old->inst[io].name, p->inst[i].name))
+      io++;
+    if (io <= old->nInst && old->inst[io].quota == p->inst[i].quota) 
+      continue;
+    if (io > old->nInst) tee(fl, "  institution %s is new\n", p->inst[i].name);
+    else tee(fl, "  institution %s quota %d -> %d\n", p->inst[i].name, 
+             old->inst[io].quota, p->inst[i].quota);
+    nChanges++;
+  }
+  return nChanges;
+}
+
+/*************************************************************************/
+void repairSeed(const struct problem *p, int seedIndex, const int *keep) {
+
+  /* Seed seedIndex of p, starting from the shifts in keep (the shifter of
+     each, -1 for the ones to fill).  They are given out as assignShift 
+     does, so the quotas and the priorities are where they would be, and 
+     then the algorithm runs as usual on the shifts that are left. */
+
+  startSeed(p, seedIndex);
+  bool saveVerbose = verbose;
+  verbose = false;                  // the kept shifts are not news 
+  for (int is = 0; is < NSHIFTS; is++) {
+    int ii = keep[is];
+    if (ii < 0) continue;
+    nextShift = is;
+    shift[is].topRequester = ii;
+    shift[is].nRequests = 0;        // no bonus for the others 
+    assignShift(0);
+    keepBonus(ii);
+    ind[ii].virginPri = 0.0;
+  }
+  verbose = saveVerbose;
+  for (int ii = 0; ii < nInd; ii++) {   // as getNewRandPri, same draws 
+    if (ind[ii].basePri <= 0.0) clearBonus(ii);
+    sumPri(ii);
+  }
+  runSeed();
+}
+
+/*************************************************************************/
+void warmStart(const char *dir, struct problem *problem, const char *policy,
+               const double *weights) {  // weights NULL => lexicographic 
+  static int oldToNew[MAXIND];
+  static bool changedInd[MAXIND];
+  static bool changedShift[NSHIFTS];
+  static int oldAssigned[NSHIFTS];
+  static int keep[NSHIFTS], bestKeep[NSHIFTS];
+
+  char name[1024];
+  snprintf(name, sizeof(name), "%s/TopSeeds.csv", dir);
+  int *seeds = NULL;                // seed index + 1000000*branch 
+  int nSeeds = readResults(name, &seeds, 0);
+  nSeeds = uniqueSeeds(seeds, nSeeds);
+  if (nSeeds == 0) fatal(1, "\nThere are no seeds in %s.\n", name);
+  struct problem *old = loadProblem(dir, policy, NULL, 0);
+  fl = fopen("AssignLog.txt", "w");
+  tee(fl, "Warm start from %s:\n", dir);
+  int nChanges = diffProblems(old, problem, oldToNew, changedInd, 
+                              changedShift);
+  tee(fl, "%d change(s), %d seed(s) from the earlier scan\n\n", nChanges,
+      nSeeds);
+
+  struct solver *oldSolver = newSolver(old, 1);
+  struct solver *solver = newSolver(problem, 1);
+  solverReference(oldSolver, engine == REFERENCE);
+  solverReference(solver, engine == REFERENCE);
+  struct result best = {.seedIndex = -1};
+  bool repaired = false;
+  for (int k = 0; k < nSeeds; k++) {
+    int seedIndex = seeds[k]%1000000;
+    branch = seeds[k]/1000000;
+    struct result r = {.assigned = oldAssigned};
+    solveOne(oldSolver, seedIndex, &r);
+    int nKept = 0, nGiven = 0;
+    for (int is = 0; is < NSHIFTS; is++) {
+      int ii = oldAssigned[is] < 0 ? -1 : oldToNew[oldAssigned[is]];
+      keep[is] = (ii < 0 || changedInd[ii] || changedShift[is]) ? -1 : ii;
+      nGiven += oldAssigned[is] >= 0;
+      nKept += keep[is] >= 0;
+    }
+    repairSeed(problem, seedIndex, keep);
+    struct result fixed = {.seedIndex = -1}, rerun = {.seedIndex = -1};
+    takeResult(seedIndex, &fixed);
+    solveOne(solver, seedIndex, &rerun);
+    branch = 0;
+    for (int pass = 0; pass < 2; pass++) {
+      struct result *x = pass ? &rerun : &fixed;
+      tee(fl, "seed %d", x->seedIndex);
+      if (x->branch) tee(fl, "/%d", x->branch);
+      tee(fl, " open = %d chisq = %d %d", x->openShifts, x->chisq, 
+          x->chisqInd);
+      if (pass) tee(fl, "\n");
+      else tee(fl, " repaired, %d of %d shifts kept\n", nKept, nGiven);
+      if (best.seedIndex < 0 || better(x, &best, weights)) {
+        best = *x;
+        repaired = ! pass;
+        if (repaired) memcpy(bestKeep, keep, sizeof(keep));
+      }
+    }
+  }
+  freeSolver(oldSolver);
+  freeSolver(solver);
+  free(seeds);
+  tee(fl, "\nBest: seed %d", best.seedIndex);
+  if (best.branch) tee(fl, "/%d", best.branch);
+  tee(fl, "%s\n", repaired ? " repaired" : "");
+  teeFlush();
+
+  verbose = true;                   // full output for the best one 
+  branch = best.branch;
+  if (repaired) repairSeed(problem, best.seedIndex, bestKeep);
+  else solveSeed(best.seedIndex);
+  branch = 0;
+  shiftTable();
+  shifterTable();
+  institutionTable();
+  verbose = false;
+  freeProblem(old);
+}
+
+/***********************************************************************/
+void main(int argc, char *argv[]) {
+
+  static struct option longOptions[] = {
+    {"priority", required_argument, 0, 'p'},
+    {"trace", required_argument, 0, 't'},
+    {"trace-all", no_argument, 0, 'a'},
+    {"decode", required_argument, 0, 'T'},
+    {"profile", required_argument, 0, 'j'},
+    {"perf", no_argument, 0, 'P'},
+    {"engine", required_argument, 0, 'e'},
+    {"threads", required_argument, 0, 'n'},
+    {"serve", required_argument, 0, 's'},
+    {"warm", required_argument, 0, 'w'},
+    {"top", required_argument, 0, 'k'},
+    {"order", required_argument, 0, 'o'},
+    {"results", required_argument, 0, 'r'},
+    {"metrics", required_argument, 0, 'm'},
+    {"status", required_argument, 0, 'S'},
+    {"status-every", required_argument, 0, 'E'},
+    {"time-budget", required_argument, 0, 'b'},
+    {"max-seeds", required_argument, 0, 'M'},
+    {"checkpoint", required_argument, 0, 'c'},
+    {"checkpoint-every", required_argument, 0, 'C'},
+    {"resume", no_argument, 0, 'R'},
+    {"shard", required_argument, 0, 'i'},
+    {"seeds", required_argument, 0, 'I'},
+    {"param", required_argument, 0, 'K'},
+    {"candidates", required_argument, 0, 'N'},
+    {"branches", required_argument, 0, 'B'},
+    {"priorities", required_argument, 0, 'F'},
+    {"pattern", required_argument, 0, 'H'},
+    {"rules", required_argument, 0, 'G'},
+    {0, 0, 0, 0}
+  };
+
+  char *policy = isatty(fileno(stdin)) ? "ask" : "fail";
+  char *traceFile = NULL;
+  char *decodeFile = NULL;
+  char *profileFile = NULL;
+  int nThreads = 1;
+  char *servePath = NULL;
+  char *warmDir = NULL;
+  int topK = 20;
+  double weights[3];
+  bool weighted = false;
+  char *resultsFile = NULL;
+  char *metricsFile = NULL;
+  char *statusFile = NULL;
+  double statusEvery = 10;
+  double timeBudget = 0;
+  int maxSeeds = 1000000;
+  char *checkpointFile = NULL;
+  double checkpointEvery = 60;
+  bool resume = false;
+  int shardFirst = 0, shardEnd = 1000000;   // the seeds of this scan 
+  int nCandidates = 32;
+  int nBranches = 0;                 // continuations of each best seed 
+  char *patternName = NULL;          // else the one of the rules 
+  int opt;
+  while ((opt = getopt_long(argc, argv, "p:t:T:j:e:n:s:w:k:o:r:m:S:b:c:", longOptions, NULL)) 
+         != -1) {
+    switch (opt) {
+    case 'p' :
+      policy = optarg;
+      if (! setPolicy(policy)) {
+        printf("Unknown priority policy %s\n", optarg);
+        exit(1);
+      }
+      break;
+    case 't' : traceFile = optarg; break;
+    case 'a' : traceAll = true; break;
+    case 'T' : decodeFile = optarg; break;
+    case 'j' : profileFile = optarg; profiling = true; break;
+    case 'P' : perfCounters = true; break;
+    case 'e' :
+      if (strcmp(optarg, "fast") == 0) engine = FAST;
+      else if (strcmp(optarg, "reference") == 0) engine = REFERENCE;
+      else {
+        printf("Unknown engine %s\n", optarg);
+        exit(1);
+      }
+      break;
+    case 'n' : nThreads = atoi(optarg); break;
+    case 's' : servePath = optarg; break;
+    case 'w' : warmDir = optarg; break;
+    case 'k' : topK = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+    case 'o' :
+      if (strcmp(optarg, "lex") == 0) weighted = false;
+      else if (sscanf(optarg, "%lf,%lf,%lf", &weights[0], &weights[1], 
+                      &weights[2]) == 3) weighted = true;
+      else {
+        printf("Unknown order %s\n", optarg);
+        exit(1);
+      }
+      break;
+    case 'r' : resultsFile = optarg; break;
+    case 'm' : metricsFile = optarg; break;
+    case 'S' : statusFile = optarg; break;
+    case 'E' : statusEvery = atof(optarg); break;
+    case 'b' : timeBudget = atof(optarg); break;
+    case 'M' : maxSeeds = atoi(optarg); break;
+    case 'c' : checkpointFile = optarg; break;
+    case 'C' : checkpointEvery = atof(optarg); break;
+    case 'R' : resume = true; break;
+    case 'i' : {
+      int i, n;
+      if (sscanf(optarg, "%d/%d", &i, &n) != 2 || n < 1 || i < 0 || i >= n) {
+        printf("The shard is I/N, with I from 0 to N - 1\n");
+        exit(1);
+      }
+      shardFirst = (int)(1000000LL*i/n);
+      shardEnd = (int)(1000000LL*(i + 1)/n);
+      break;
+    }
+    case 'I' :
+      if (sscanf(optarg, "%d-%d", &shardFirst, &shardEnd) != 2 || 
+          shardFirst < 0 || shardEnd < shardFirst || shardEnd > 999999) {
+        printf("The seeds are FIRST-LAST, from 0 to 999999\n");
+        exit(1);
+      }
+      shardEnd++;
+      break;
+    case 'K' :
+      if (! setParam(optarg)) {
+        printf("Unknown constant or file %s\n", optarg);
+        exit(1);
+      }
+      break;
+    case 'N' : nCandidates = atoi(optarg); break;
+    case 'B' : nBranches = atoi(optarg) > 0 ? atoi(optarg) : 0; break;
+    case 'F' :
+      if (strcmp(optarg, "float") == 0) fixedPri = false;
+      else if (strcmp(optarg, "fixed") == 0) fixedPri = true;
+      else {
+        printf("Unknown priorities %s\n", optarg);
+        exit(1);
+      }
+      break;
+    case 'H' :
+      if (! setPattern(optarg)) {
+        printf("Unknown shift pattern %s\n", optarg);
+        exit(1);
+      }
+      patternName = optarg;
+      break;
+    case 'G' :
+      if (! setRules(optarg)) {
+        printf("Unknown rules %s\n", optarg);
+        exit(1);
+      }
+      break;
+    default :
+      printf("usage: %s [-p ask|fail|default:P|table:FILE] [-t FILE]"
+             " [--trace-all] [-T FILE] [-j FILE] [--perf]\n"
+             "       [-e fast|reference] [-n threads] [-s SOCKET] [-w DIR]"
+             " [-k K]\n       [-o lex|W1,W2,W3] [-r FILE] [-m FILE]"
+             " [-S FILE] [--status-every=S]\n       [-b SECONDS]"
+             " [--max-seeds=N] [-c FILE] [--checkpoint-every=S]"
+             " [--resume]\n       [--shard=I/N] [--seeds=FIRST-LAST]"
+             " [--param=NAME=VALUE|FILE] [--candidates=N]\n"
+             "       [--branches=B] [--priorities=float|fixed]"
+             " [--pattern=8h|12h]\n       [--rules=icarus|nova]"
+             "\n"
+             "       [seedIndex[/branch] | merge FILE... | batch SEEDS... |"
+             " sweep FILE | tune DIR... |\n"
+             "        sensitivity SEEDS...]\n", 
+             argv[0]);
+      exit(1);
+    }
+  }
+  setPattern(patternName ? patternName : rules->pattern);  // days of rules
+
+  startWriter();                     // all output goes through tee 
+  atexit(stopWriter);
+  if (servePath) {
+    serve(servePath, policy, nThreads);
+    stopWriter();
+    return;
+  }
+  
+  bool mergeMode = optind < argc && strcmp(argv[optind], "merge") == 0;
+  bool batchMode = optind < argc && strcmp(argv[optind], "batch") == 0;
+  bool sweepMode = optind + 1 < argc && strcmp(argv[optind], "sweep") == 0;
+  bool tuneMode = optind < argc && strcmp(argv[optind], "tune") == 0;
+  bool sensitivityMode = optind < argc && 
+    strcmp(argv[optind], "sensitivity") == 0;
+  bool scanMode = optind >= argc;
+  int seedIndex = scanMode || mergeMode || batchMode || sweepMode || 
+    tuneMode || sensitivityMode ? 0 : atoi(argv[optind]);
+  if (! scanMode && strchr(argv[optind], '/')) {   // a branch of the seed 
+    branch = atoi(strchr(argv[optind], '/') + 1);
+    if (branch < 0) {
+      printf("The branch of a seed is 0 or more\n");
+      exit(1);
+    }
+  }
+  if (resultsFile == NULL) 
+    resultsFile = sweepMode ? "Sweep.csv" : tuneMode ? "Tuned.txt" 
+      : sensitivityMode ? "Sensitivity.csv" : "TopSeeds.csv";
+
+  /* The input is read and the priorities are settled once, so a scan 
+     never asks inside the seed loop; errors stop the program */
+
+  struct problem *problem = loadProblem(".", policy, NULL, 0);
+  if (decodeFile) {                  // render a trace instead of running 
+    decodeTrace(decodeFile, scanMode ? -1 : seedIndex);
+    stopWriter();
+    return;
+  }
+  if (warmDir) {                     // late changes to an earlier run 
+    warmStart(warmDir, problem, policy, weighted ? weights : NULL);
+    teeClose(fl);
+    stopWriter();
+    return;
+  }
+  fl = fopen("AssignLog.txt", resume ? "a" : "w");  // open the log file 
+  if (mergeMode) {                   // partial results of a scan 
+    mergeScans(argv + optind + 1, argc - optind - 1, problem, topK, 
+               weighted ? weights : NULL, resultsFile, statusFile, 
+               checkpointFile);
+    teeClose(fl);
+    stopWriter();
+    return;
+  }
+  if (batchMode) {                   // full output for a list of seeds 
+    runBatch(argv + optind + 1, argc - optind - 1, nThreads);
+    teeClose(fl);
+    stopWriter();
+    return;
+  }
+  if (sweepMode) {                   // variations of the input 
+    int endSeed = maxSeeds < shardEnd - shardFirst ? shardFirst + maxSeeds
+                                                   : shardEnd;
+    runSweep(argv[optind + 1], problem, shardFirst, endSeed, nThreads, 
+             resultsFile);
+    teeClose(fl);
+    stopWriter();
+    return;
+  }
+  if (sensitivityMode) {             // one shifter changed at a time 
+    runSensitivity(argv + optind + 1, argc - optind - 1, problem, nThreads,
+                   resultsFile);
+    teeClose(fl);
+    stopWriter();
+    return;
+  }
+  if (tuneMode) {                    // constants that find good seeds early 
+    runTune(argv + optind + 1, argc - optind - 1, policy, nCandidates, 
+            maxSeeds, nThreads, weighted ? weights : NULL, resultsFile);
+    teeClose(fl);
+    stopWriter();
+    return;
+  }
+  if (traceFile) startTrace(traceFile);
+  double started = now();
+
+  if (! scanMode) {                  // full output for one seed 
+    verbose = true;
+    solveSeed(seedIndex);
+    phaseStart(PH_REPORT);
+    traceSeed(seedIndex, true);
+    shiftTable();                    // print shift table 
+    shifterTable();                  // print shifter table  
+    institutionTable();              // print institution table 
+    phaseStop(PH_REPORT);
+  }
+  else {                             // test 1,000,000 seeds 
+    presolveReport(problem);
+    struct solver *solver = newSolver(problem, nThreads);
+    solverReference(solver, engine == REFERENCE);
+    solverTop(solver, topK, weighted ? weights : NULL);
+    if (metricsFile && solverMetrics(solver, metricsFile) != 0) 
+      fatal(1, "\nCould not write %s.\n", metricsFile);
+    char shardFile[64];              // the partial result of a block 
+    if (checkpointFile == NULL && (shardFirst > 0 || shardEnd < 1000000)) {
+      snprintf(shardFile, sizeof(shardFile), "Scan-%06d-%06d.txt", 
+               shardFirst, shardEnd - 1);
+      checkpointFile = shardFile;
+    }
+    solverStats(solver, statusFile != NULL || checkpointFile != NULL);
+    double statusWritten = now();
+    double checkpointWritten = now();
+    struct result runBest = {.seedIndex = -1}; // the best so far, for the reports 
+    int slice = 64*nThreads;         // short, so a stop comes soon 
+    struct result *results = calloc(slice, sizeof(struct result));
+    int first = shardFirst;
+    int endSeed = maxSeeds < shardEnd - first ? first + maxSeeds : shardEnd;
+
+    static struct deviation stateInst[MAXINST];
+    struct scanState state = {.fingerprint = problemFingerprint(problem),
+      .first = first, .next = first, .end = endSeed, .weighted = weighted,
+      .report = {.seedIndex = -1}, .k = topK, 
+      .best = malloc(topK*sizeof(struct result)), 
+      .stats = {.inst = stateInst}, .nInst = problem->nInst};
+    if (weighted) memcpy(state.weights, weights, sizeof(state.weights));
+    if (resume && checkpointFile && loadScan(checkpointFile, &state)) {
+      if (state.fingerprint != problemFingerprint(problem) || 
+          state.first != first || state.weighted != weighted || (weighted && 
+          memcmp(state.weights, weights, sizeof(weights))))
+        fatal(1, "\n%s is a checkpoint of another input or order.\n", 
+              checkpointFile);
+      if (state.savedK < topK) 
+        fatal(1, "\n%s keeps the %d best seeds; resume it with -k %d.\n",
+              checkpointFile, state.savedK, state.savedK);
+      state.end = endSeed > state.next ? endSeed : state.next;  // this run's
+      resumeState(&state, solver);
+      runBest = state.report;
+      first = state.next;
+      tee(fl, "\nResuming from %s at seed %d\n", checkpointFile, first);
+    }
+    double spent = state.seconds;    // on the seeds before this run 
+    signal(SIGINT, stopScan);
+    signal(SIGTERM, stopScan);
+    while (first < endSeed && ! stopRequested && 
+           (timeBudget <= 0 || now() - started < timeBudget)) {
+      int n = endSeed - first < slice ? endSeed - first : slice;
+      solveRange(solver, first, n, results);
+      for (int k = 0; k < n; k++) {
+        int iloop = first + k;
+        struct result *r = &results[k];
+        bool reported = reportSeed(r, &runBest, weighted ? weights : NULL)
+          || iloop % 10000 == 0;
+        if (reported) {
+          tee (fl,"seed %d open = %d chisq = %d %d\n", iloop, r->openShifts, 
+               r->chisq, r->chisqInd);
+          teeFlush();                 // the operator is watching these 
+        }
+        if (tracing && (reported || traceAll)) {  /* the solver threads 
+                                                     kept no trace; run the
+                                                     seed again for it */
+          solveProblem(problem, iloop);
+          traceSeed(iloop, true);
+        }
+      }
+      first += n;
+      if (checkpointFile && now() - checkpointWritten >= checkpointEvery) {
+        takeState(&state, solver, first, &runBest, spent + now() - started);
+        if (! saveScan(checkpointFile, &state)) 
+          tee(NULL, "\nCould not write the checkpoint %s.\n", 
+              checkpointFile);
+        checkpointWritten = now();
+      }
+      if (statusFile && now() - statusWritten >= statusEvery) {
+        if (solverStatus(solver, statusFile) != 0) 
+          tee(NULL, "\nCould not write the status file %s.\n", statusFile);
+        statusWritten = now();
+      }
+    }
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    free(results);
+    if (statusFile && solverStatus(solver, statusFile) != 0) 
+      tee(NULL, "\nCould not write the status file %s.\n", statusFile);
+    if (checkpointFile) {
+      takeState(&state, solver, first, &runBest, spent + now() - started);
+      if (! saveScan(checkpointFile, &state)) 
+        tee(NULL, "\nCould not write the checkpoint %s.\n", checkpointFile);
+    }
+    free(state.best);
+    tee(fl, "\n%d seeds scanned, %d to %d, in %.1f s%s\n", 
+        first - shardFirst, shardFirst, first - 1, now() - started, 
+        first == endSeed ? "" : stopRequested ? ", stopped by a signal" 
+                                              : ", the time budget is spent");
+
+    /* The lines above were the best as they were found; a seed reported 
+       early may have been beaten since.  These are the final standings,
+       with the branches of the best seeds among them. */
+
+    struct result *best = malloc(topK*sizeof(struct result));
+    int nBest = solverBest(solver, best);
+    if (nBranches > 0 && nBest > 0 && ! stopRequested) {
+      int *seeds = malloc(nBest*sizeof(int));
+      for (int k = 0; k < nBest; k++) seeds[k] = best[k].seedIndex;
+      struct result *branches = calloc(nBest*nBranches, 
+                                       sizeof(struct result));
+      double branched = now();
+      solveBranches(solver, seeds, nBest, nBranches, branches);
+      tee(fl, "\n%d branches of each of the best %d seeds in %.1f s\n", 
+          nBranches, nBest, now() - branched);
+      free(branches);
+      free(seeds);
+      nBest = solverBest(solver, best);
+    }
+    tee(fl, "\nBest %d seeds:\n", nBest);
+    for (int k = 0; k < nBest; k++) {
+      tee(fl, "seed %d", best[k].seedIndex);
+      if (best[k].branch) tee(fl, "/%d", best[k].branch);
+      tee(fl, " open = %d chisq = %d %d\n", best[k].openShifts, 
+          best[k].chisq, best[k].chisqInd);
+    }
+    writeResults(resultsFile, best, nBest, weighted ? weights : NULL, 
+                 nBranches > 0);
+    free(best);
+    freeSolver(solver);
+  }
+  teeClose(fl);
+  if (tracing) fclose(ft);
+  if (profiling) dumpProfile(profileFile, now() - started);
+  stopWriter();
 }
+#endif
@@ -0,0 +1,120 @@
+//  The shift assignment algorithm as a library.  See assign.c.
+
+/* A problem is the parsed input: the 4 files read from a directory, or
+   the same text held in memory.  A solver runs seeds of a problem, one
+   at a time in the calling thread or a range of them in threads of its
+   own, and each seed gives a result: who got each shift and the metrics
+   of report.  A problem is read only once it is built, so any number of
+   solvers and threads may share it.  The threads of a solver wait for
+   the next range between calls, so a solver that is kept (as by the 
+   daemon, --serve) starts them only once.
+
+   The library is assign.c without its main, built with the same NSHIFTS
+   and capacity macros as the program that uses it:
+
+     gcc -O2 -pthread -DASSIGN_LIBRARY -c assign.c
+     ar rcs libassign.a assign.o
+
+   The state of a seed is thread local and large at 10 times the current
+   size, so a thread of the caller that runs solveOne needs a stack of
+   solverStackSize() bytes; the solver's own threads get one. */
+
+#ifndef ASSIGN_H
+#define ASSIGN_H
+
+#include <stddef.h>
+
+struct problem;            // opaque
+struct solver;             // opaque
+
+struct result {
+  int seedIndex;
+  int openShifts;          // sum of the institutional quota differences
+  int chisq;               // sum of their squares
+  int chisqInd;            // individual chisq, 0 at best
+  int *assigned;           /* shifter of each shift, -1 if open; NULL or
+                              room for problemShifts() entries */
+  int *points;             /* points assigned to each shifter; NULL or
+                              room for problemShifters() entries */
+  int assignments;         // shifts given out, consecutive ones included 
+  int trades;              // trades made for a consecutive shift 
+  int donations;           // shifts donated 
+  float seconds;           // time the seed took in solveOne 
+  int branch;              // continuation after LoP-1, 0 for the seed 
+};
+
+/* policy is what to do with shifters who asked for special priority but
+   are not in Pri.csv: "fail", "default:P" or "table:FILE", as the -p
+   option of the program; NULL is "fail".  On failure NULL is returned
+   and the reason is in error; with error NULL a failure stops the 
+   program with the message, as the program itself does.  The solve
+   routines return 0, or -1 for seeds outside 0 to 999999. */
+
+struct problem *loadProblem(const char *dir, const char *policy,
+                            char *error, int errorSize);
+struct problem *parseProblem(const char *instText, const char *shiftText,
+                             const char *priText, const char *indText,
+                             const char *policy, char *error, int errorSize);
+void freeProblem(struct problem *p);
+int problemShifts(const struct problem *p);
+int problemShifters(const struct problem *p);
+const char *shifterName(const struct problem *p, int ii);
+unsigned long long problemFingerprint(const struct problem *p);  /* a hash
+                                      of the input the seeds depend on */
+
+/* A copy of a problem can be given other quotas and requests without the
+   input being read again, as if the files had been edited; the seeds 
+   draw the same random priorities.  setQuota and setRequest (the 
+   shifter by ECLID or name) return the old value, or -1 if there is no 
+   such institution or shifter or the value is negative. */
+
+struct problem *copyProblem(const struct problem *p);
+int setQuota(struct problem *p, const char *institution, int quota);
+int setRequest(struct problem *p, const char *shifter, int points);
+
+struct solver *newSolver(const struct problem *p, int nThreads);
+void solverReference(struct solver *s, int reference);  // 1 => reference
+int solveOne(struct solver *s, int seedIndex, struct result *r);
+int solveRange(struct solver *s, int first, int n, struct result *r);
+void freeSolver(struct solver *s);
+
+/* A solver can keep the best k results of the seeds it runs, a list per
+   thread that solverBest merges into best (room for k), best first; it
+   returns how many there are.  The order is the one of the scan, fewer 
+   open shifts, then a lower chisq, then a lower chisqInd, or with 
+   weights the lowest weights[0]*openShifts + weights[1]*chisq + 
+   weights[2]*chisqInd.  Either way an overfilled quota (openShifts < 0) 
+   comes last and ties go to the lower seed, then the lower branch.  
+   solverTop empties the lists; k = 0 stops keeping them. */
+
+void solverTop(struct solver *s, int k, const double *weights);
+int solverBest(struct solver *s, struct result *best);
+
+/* solveBranches runs branches 1 to n of each of the seeds, into r (room
+   for nSeeds*n), those of seeds[0] first: each is the seed up to the 
+   switch to LoP-2, and from there other random priorities.  LoP-1 runs 
+   once per seed and thread; the branches go to the lists of solverTop 
+   but not to the metrics or statistics.  It returns 0, or -1 if a seed 
+   is outside 0 to 999999. */
+
+int solveBranches(struct solver *s, const int *seeds, int nSeeds, int n,
+                  struct result *r);
+
+/* solverMetrics records the metrics of every seed the solver runs from 
+   then on in a columnar file, each thread writing its own seeds in 
+   place (the layout is in assign.c, readMetrics.py reads it).  It 
+   returns 0, or -1 if the file could not be made. */
+
+int solverMetrics(struct solver *s, const char *fileName);
+
+/* solverStats(s, 1) starts histograms of the outcomes of the seeds, one 
+   set per thread, and solverStatus merges them and writes them to 
+   fileName as JSON with their quantiles; call it between solveRange
+   calls.  solverStats(s, 0) drops them.  solverStatus returns 0, or -1 
+   if the file could not be written. */
+
+void solverStats(struct solver *s, int on);
+int solverStatus(struct solver *s, const char *fileName);
+size_t solverStackSize();
+
+#endif
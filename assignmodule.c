@@ -0,0 +1,387 @@
+//  Python bindings of the assignment algorithm.  See assign.h.
+
+/* The module "assign" runs the algorithm in the Python process, on input
+   that never goes through a file:
+
+     import assign
+     p = assign.Problem(inst, shift, pri, ind, policy="fail")
+     p = assign.load("2020")               # or the 4 files of a directory
+     r = p.solve(42)                       # one seed
+     s = p.scan(0, 100000, threads=8)      # a range of seeds
+
+   Each of inst, shift, pri and ind is the text of the file, or its rows:
+   a sequence of rows, each a sequence of fields in the order of the
+   file.  A field may be a string, a number or None (an empty field); a
+   field that is itself a sequence, such as a NumPy array of the LoP-1
+   requests, stands for one field per element, "1" where the element is
+   true and empty where it is not.
+
+   solve returns a dict with seed, open, chisq and chisqInd (the metrics
+   of report), assigned (the shifter of each shift, -1 if open) and
+   points (the points of each shifter).  scan returns a dict of arrays,
+   one entry per seed: seed, open, chisq, chisqInd and, with
+   assignments=True, assigned with one row per seed.  The arrays are
+   NumPy arrays when NumPy can be imported and int32 memoryviews
+   otherwise.  The interpreter lock is released while the seeds run, so
+   other Python threads go on; engine="reference" runs the algorithm
+   exactly as written.
+
+   Built with the same NSHIFTS and capacity macros as the program:
+
+     gcc -O2 -pthread -shared -fPIC $(python3-config --includes) \
+         -o assign$(python3-config --extension-suffix) assignmodule.c */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define ASSIGN_LIBRARY    // assign.c without its main
+#include "assign.c"
+
+typedef struct {
+  PyObject_HEAD
+  struct problem *p;
+} ProblemObject;
+
+static PyTypeObject ProblemType;
+
+/*************************************************************************/
+static int addField(PyObject *text, PyObject *field) {
+
+  // appends the text of one field, or of a sequence of them; -1 on error
+
+  if (field == Py_None) return 0;
+  if (PyUnicode_Check(field)) return PyList_Append(text, field);
+  if (PyLong_Check(field) || PyFloat_Check(field)) {
+    PyObject *s = PyObject_Str(field);
+    if (s == NULL) return -1;
+    int status = PyList_Append(text, s);
+    Py_DECREF(s);
+    return status;
+  }
+  PyObject *iter = PyObject_GetIter(field);   // requests, one per element
+  if (iter == NULL) return -1;
+  PyObject *comma = PyUnicode_FromString(",");
+  PyObject *one = PyUnicode_FromString("1");
+  PyObject *item;
+  bool first = true;
+  int status = 0;
+  while (status == 0 && (item = PyIter_Next(iter))) {
+    int truth = PyObject_IsTrue(item);
+    Py_DECREF(item);
+    if (truth < 0) status = -1;
+    else {
+      if (! first) status = PyList_Append(text, comma);
+      if (status == 0 && truth) status = PyList_Append(text, one);
+      first = false;
+    }
+  }
+  if (PyErr_Occurred()) status = -1;
+  Py_DECREF(iter);
+  Py_DECREF(comma);
+  Py_DECREF(one);
+  return status;
+}
+
+/*************************************************************************/
+static PyObject *inputBytes(PyObject *input) {
+
+  // the text of an input file, from its text or from its rows, as bytes
+
+  if (PyBytes_Check(input)) {
+    Py_INCREF(input);
+    return input;
+  }
+  if (PyUnicode_Check(input)) return PyUnicode_AsUTF8String(input);
+  PyObject *text = PyList_New(0);
+  PyObject *rows = PyObject_GetIter(input);
+  if (rows == NULL) {
+    Py_DECREF(text);
+    return NULL;
+  }
+  PyObject *comma = PyUnicode_FromString(",");
+  PyObject *separator = PyUnicode_FromString("\r");
+  PyObject *row, *field;
+  int nRows = 0;
+  while ((row = PyIter_Next(rows))) {
+    if (nRows++) PyList_Append(text, separator);
+    PyObject *fields = PyObject_GetIter(row);
+    int nFields = 0;
+    while (fields && (field = PyIter_Next(fields))) {
+      if (nFields++) PyList_Append(text, comma);
+      int status = addField(text, field);
+      Py_DECREF(field);
+      if (status < 0) break;
+    }
+    Py_XDECREF(fields);
+    Py_DECREF(row);
+    if (PyErr_Occurred()) break;
+  }
+  Py_DECREF(rows);
+  Py_DECREF(comma);
+  PyObject *joined = NULL;
+  if (! PyErr_Occurred()) {
+    PyObject *empty = PyUnicode_FromString("");
+    PyObject *all = PyUnicode_Join(empty, text);
+    Py_DECREF(empty);
+    if (all) {
+      joined = PyUnicode_AsUTF8String(all);
+      Py_DECREF(all);
+    }
+  }
+  Py_DECREF(separator);
+  Py_DECREF(text);
+  return joined;
+}
+
+/*************************************************************************/
+static PyObject *newArray(int rows, int columns, int **data) {
+
+  /* A zeroed int32 array of rows x columns (a vector when columns is 0):
+     a NumPy array if NumPy is there, a memoryview otherwise.  *data
+     points at its elements. */
+
+  int n = columns ? rows*columns : rows;
+  PyObject *bytes = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t)n*4);
+  if (bytes == NULL) return NULL;
+  memset(PyByteArray_AS_STRING(bytes), 0, (size_t)n*4);
+  *data = (int *)PyByteArray_AS_STRING(bytes);
+  PyObject *view = PyMemoryView_FromObject(bytes);
+  Py_DECREF(bytes);
+  if (view == NULL) return NULL;
+  PyObject *shape = columns ? Py_BuildValue("(ii)", rows, columns)
+                            : Py_BuildValue("(i)", rows);
+  PyObject *cast = PyObject_CallMethod(view, "cast", "sO", "i", shape);
+  Py_DECREF(view);
+  Py_DECREF(shape);
+  if (cast == NULL) return NULL;
+  PyObject *numpy = PyImport_ImportModule("numpy");
+  if (numpy == NULL) {               // no NumPy: the memoryview will do
+    PyErr_Clear();
+    return cast;
+  }
+  PyObject *array = PyObject_CallMethod(numpy, "asarray", "O", cast);
+  Py_DECREF(numpy);
+  Py_DECREF(cast);
+  return array;
+}
+
+/*************************************************************************/
+static PyObject *wrapProblem(struct problem *p, char *error) {
+  if (p == NULL) {
+    char *reason = error + (error[0] == '\n');
+    reason[strcspn(reason, "\n")] = '\0';
+    PyErr_SetString(PyExc_ValueError, reason);
+    return NULL;
+  }
+  ProblemObject *self = PyObject_New(ProblemObject, &ProblemType);
+  if (self == NULL) {
+    freeProblem(p);
+    return NULL;
+  }
+  self->p = p;
+  return (PyObject *)self;
+}
+
+/*************************************************************************/
+static PyObject *problemNew(PyTypeObject *type, PyObject *args,
+                            PyObject *kwds) {
+  static char *keywords[] = {"inst", "shift", "pri", "ind", "policy", NULL};
+  PyObject *input[4];
+  const char *policy = NULL;
+  if (! PyArg_ParseTupleAndKeywords(args, kwds, "OOOO|z", keywords,
+        &input[0], &input[1], &input[2], &input[3], &policy)) return NULL;
+  PyObject *text[4] = {NULL, NULL, NULL, NULL};
+  for (int which = 0; which < 4; which++)
+    if ((text[which] = inputBytes(input[which])) == NULL) {
+      for (int k = 0; k < which; k++) Py_DECREF(text[k]);
+      return NULL;
+    }
+  char error[256] = "";
+  struct problem *p;
+  Py_BEGIN_ALLOW_THREADS
+  p = parseProblem(PyBytes_AS_STRING(text[0]), PyBytes_AS_STRING(text[1]),
+                   PyBytes_AS_STRING(text[2]), PyBytes_AS_STRING(text[3]),
+                   policy, error, sizeof(error));
+  Py_END_ALLOW_THREADS
+  for (int which = 0; which < 4; which++) Py_DECREF(text[which]);
+  return wrapProblem(p, error);
+}
+
+/*************************************************************************/
+static void problemDealloc(ProblemObject *self) {
+  if (self->p) freeProblem(self->p);
+  Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+/*************************************************************************/
+static struct solver *makeSolver(ProblemObject *self, int threads,
+                                 const char *engineName) {
+  if (strcmp(engineName, "fast") && strcmp(engineName, "reference")) {
+    PyErr_Format(PyExc_ValueError, "unknown engine %s", engineName);
+    return NULL;
+  }
+  struct solver *s = newSolver(self->p, threads);
+  solverReference(s, strcmp(engineName, "reference") == 0);
+  return s;
+}
+
+/*************************************************************************/
+static PyObject *problemSolve(ProblemObject *self, PyObject *args,
+                              PyObject *kwds) {
+  static char *keywords[] = {"seed", "engine", NULL};
+  int seedIndex;
+  const char *engineName = "fast";
+  if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|s", keywords,
+        &seedIndex, &engineName)) return NULL;
+  if (seedIndex < 0 || seedIndex >= 1000000)
+    return PyErr_Format(PyExc_ValueError, "seed %d is not in 0 to 999999",
+                        seedIndex);
+  struct result r;
+  PyObject *assigned = newArray(problemShifts(self->p), 0, &r.assigned);
+  PyObject *points = newArray(problemShifters(self->p), 0, &r.points);
+  struct solver *s = makeSolver(self, 1, engineName);
+  if (assigned == NULL || points == NULL || s == NULL) {
+    Py_XDECREF(assigned);
+    Py_XDECREF(points);
+    if (s) freeSolver(s);
+    return NULL;
+  }
+  Py_BEGIN_ALLOW_THREADS
+  solveOne(s, seedIndex, &r);
+  freeSolver(s);
+  Py_END_ALLOW_THREADS
+  return Py_BuildValue("{s:i,s:i,s:i,s:i,s:N,s:N}", "seed", seedIndex,
+                       "open", r.openShifts, "chisq", r.chisq,
+                       "chisqInd", r.chisqInd, "assigned", assigned,
+                       "points", points);
+}
+
+/*************************************************************************/
+static PyObject *problemScan(ProblemObject *self, PyObject *args,
+                             PyObject *kwds) {
+  static char *keywords[] = {"first", "count", "threads", "engine",
+                             "assignments", NULL};
+  int first, count, threads = 1, assignments = 0;
+  const char *engineName = "fast";
+  if (! PyArg_ParseTupleAndKeywords(args, kwds, "ii|isp", keywords, &first,
+        &count, &threads, &engineName, &assignments)) return NULL;
+  if (first < 0 || count < 0 || first + count > 1000000)
+    return PyErr_Format(PyExc_ValueError, "seeds %d to %d are not in 0 to "
+                        "999999", first, first + count - 1);
+  int nShifts = problemShifts(self->p);
+  int *seeds, *open, *chisqs, *chisqInds, *assigned = NULL;
+  PyObject *result = PyDict_New();
+  PyObject *arrays[5] = {newArray(count, 0, &seeds),
+    newArray(count, 0, &open), newArray(count, 0, &chisqs),
+    newArray(count, 0, &chisqInds),
+    assignments ? newArray(count, nShifts, &assigned) : NULL};
+  const char *names[5] = {"seed", "open", "chisq", "chisqInd", "assigned"};
+  for (int k = 0; k < 5; k++) {
+    if (arrays[k]) PyDict_SetItemString(result, names[k], arrays[k]);
+    Py_XDECREF(arrays[k]);
+  }
+  struct solver *s = makeSolver(self, threads, engineName);
+  if (PyErr_Occurred() || s == NULL) {
+    if (s) freeSolver(s);
+    Py_DECREF(result);
+    return NULL;
+  }
+  struct result *results = calloc(count ? count : 1, sizeof(struct result));
+  for (int k = 0; k < count; k++)
+    if (assigned) results[k].assigned = &assigned[(size_t)k*nShifts];
+  Py_BEGIN_ALLOW_THREADS
+  solveRange(s, first, count, results);
+  freeSolver(s);
+  Py_END_ALLOW_THREADS
+  for (int k = 0; k < count; k++) {
+    seeds[k] = results[k].seedIndex;
+    open[k] = results[k].openShifts;
+    chisqs[k] = results[k].chisq;
+    chisqInds[k] = results[k].chisqInd;
+  }
+  free(results);
+  return result;
+}
+
+/*************************************************************************/
+static PyObject *problemNames(ProblemObject *self, PyObject *unused) {
+  int n = problemShifters(self->p);
+  PyObject *names = PyList_New(n);
+  for (int ii = 0; ii < n; ii++)
+    PyList_SET_ITEM(names, ii, PyUnicode_DecodeLatin1(
+      shifterName(self->p, ii), strlen(shifterName(self->p, ii)), NULL));
+  return names;
+}
+
+/*************************************************************************/
+static PyObject *problemGet(ProblemObject *self, void *which) {
+  return PyLong_FromLong(which ? problemShifters(self->p)
+                               : problemShifts(self->p));
+}
+
+/*************************************************************************/
+static PyObject *moduleLoad(PyObject *module, PyObject *args,
+                            PyObject *kwds) {
+  static char *keywords[] = {"dir", "policy", NULL};
+  const char *dir;
+  const char *policy = NULL;
+  if (! PyArg_ParseTupleAndKeywords(args, kwds, "s|z", keywords, &dir,
+        &policy)) return NULL;
+  char error[256] = "";
+  struct problem *p;
+  Py_BEGIN_ALLOW_THREADS
+  p = loadProblem(dir, policy, error, sizeof(error));
+  Py_END_ALLOW_THREADS
+  return wrapProblem(p, error);
+}
+
+/*************************************************************************/
+static PyMethodDef problemMethods[] = {
+  {"solve", (PyCFunction)problemSolve, METH_VARARGS | METH_KEYWORDS,
+   "solve(seed, engine='fast') -> dict: one seed"},
+  {"scan", (PyCFunction)problemScan, METH_VARARGS | METH_KEYWORDS,
+   "scan(first, count, threads=1, engine='fast', assignments=False) -> "
+   "dict of arrays: a range of seeds"},
+  {"names", (PyCFunction)problemNames, METH_NOARGS,
+   "names() -> list: the shifter names, in shifter order"},
+  {NULL}
+};
+
+static PyGetSetDef problemGetSet[] = {
+  {"shifts", (getter)problemGet, NULL, "number of shifts", NULL},
+  {"shifters", (getter)problemGet, NULL, "number of shifters", (void *)1},
+  {NULL}
+};
+
+static PyTypeObject ProblemType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  .tp_name = "assign.Problem",
+  .tp_basicsize = sizeof(ProblemObject),
+  .tp_dealloc = (destructor)problemDealloc,
+  .tp_flags = Py_TPFLAGS_DEFAULT,
+  .tp_doc = "Problem(inst, shift, pri, ind, policy=None): the parsed input",
+  .tp_methods = problemMethods,
+  .tp_getset = problemGetSet,
+  .tp_new = problemNew,
+};
+
+static PyMethodDef moduleMethods[] = {
+  {"load", (PyCFunction)moduleLoad, METH_VARARGS | METH_KEYWORDS,
+   "load(dir, policy=None) -> Problem: the 4 input files of dir"},
+  {NULL}
+};
+
+static struct PyModuleDef assignModule = {
+  PyModuleDef_HEAD_INIT, "assign",
+  "The shift assignment algorithm, in process", -1, moduleMethods
+};
+
+/*************************************************************************/
+PyMODINIT_FUNC PyInit_assign() {
+  if (PyType_Ready(&ProblemType) < 0) return NULL;
+  PyObject *module = PyModule_Create(&assignModule);
+  if (module == NULL) return NULL;
+  Py_INCREF(&ProblemType);
+  PyModule_AddObject(module, "Problem", (PyObject *)&ProblemType);
+  PyModule_AddIntConstant(module, "NSHIFTS", NSHIFTS);
+  return module;
+}
@@ -0,0 +1,248 @@
+//  Benchmarks of the assignment program on synthetic (or real) inputs.
+
+/* bench times the hot routines of assign.c one at a time and then the
+   whole thing, on a problem written by synthWrite (see synth.c) at any
+   scale:
+
+     qualified           every (shifter, shift) pair of the LoP-1 requests
+     prepareShifts       one full pass over the open shifts at LoP-1
+     prepareConsecutive  every shift as nextShift, at the end of LoP-1
+                         when most shifts are closed and trades are searched
+     findDonors          one pass over the closed shifts before donation
+     donationTime        the whole donation, findReceiver included, from
+                         a snapshot taken after LoP-2
+     solveSeed           one seed from reading the input to donation
+     scan                seeds per second of the scan, report included,
+                         with the input read once (solveRange)
+
+   The number of shifts is fixed at compile time, so the scale is chosen
+   when bench is built.  The current size and 10 times the current size:
+
+     gcc -O2 -pthread -o bench bench.c synth.c -lm
+     gcc -O2 -pthread -DNSHIFTS=900 -DMAXIND=2500 -DMAXINST=200 \
+         -o bench bench.c synth.c -lm
+
+   Options:
+     -d DIR     write the inputs in DIR (default: a new directory in /tmp)
+     -e         use the inputs already in DIR instead of writing them,
+                e.g. the real ones
+     -g         only write the inputs
+     -s N       number of shifters (default 4/3 of the shifts)
+     -i N       number of institutions (default 1/8 of the shifts + 2)
+     -r F       fraction of shifts requested at LoP-1 (default 0.25)
+     -R F       extra fraction requested at LoP-2 (default 0.15)
+     -c F       fraction asking for consecutive shifts (default 0.2)
+     -x F       fraction asking for special priority (default 0.3)
+     -z F       fraction of institutions with zero quota (default 0.05)
+     -S N       seed of the generator (default 1)
+     -n N       number of seeds of the scan (default 1000)
+     -m T       minimum time of each benchmark in seconds (default 0.5) */
+
+#define ASSIGN_LIBRARY    // assign.c without its main
+#include "assign.c"
+#include <sys/stat.h>
+#include "synth.h"
+
+double minTime = 0.5;     // seconds each benchmark runs at least
+
+/*************************************************************************/
+void result(char *name, long calls, double seconds, char *unit) {
+  tee(NULL, "%-20s %10ld calls %12.1f ns/%s\n", name, calls,
+      1e9*seconds/calls, unit);
+}
+
+/*************************************************************************/
+void benchQualified() {
+  loadSeed(0);
+  long calls = 0;
+  int count = 0;                      // keeps the calls from being dropped
+  double start = now();
+  do {
+    for (int is = 0; is < NSHIFTS; is++)
+      for (int ii = 0; ii < nInd; ii++) count += qualified(ii, is);
+    calls += (long)NSHIFTS*nInd;
+  } while (now() - start < minTime);
+  result("qualified", calls, now() - start, "call");
+  if (count < 0) tee(NULL, "%d\n", count);
+}
+
+/*************************************************************************/
+void benchPrepareShifts() {
+  loadSeed(0);
+  long calls = 0;
+  double start = now();
+  do {
+    prepareShifts();
+    calls++;
+  } while (now() - start < minTime);
+  result("prepareShifts", calls, now() - start, "call");
+}
+
+/*************************************************************************/
+void benchPrepareConsecutive() {
+  loadSeed(0);
+  algorithm();                        // LoP-1 done, lop1 still set
+  prepareShifts();
+  long calls = 0;
+  double start = now();
+  do {
+    for (nextShift = 0; nextShift < NSHIFTS; nextShift++) {
+      if (shift[nextShift].nRequests == 0) continue;
+      prepareConsecutive();
+      calls++;
+    }
+  } while (now() - start < minTime && calls > 0);
+  if (calls > 0)
+    result("prepareConsecutive", calls, now() - start, "call");
+}
+
+/*************************************************************************/
+void benchDonation() {
+
+  /* Donation changes the state, so every pass starts again from a copy of
+     the state after LoP-2.  The copy is timed on its own as well. */
+
+  static struct individual indCopy[MAXIND];
+  static struct institution instCopy[MAXINST];
+  static struct shifts shiftCopy[NSHIFTS];
+
+  loadSeed(0);
+  algorithm();
+  switchLoP();
+  algorithm();
+  memcpy(indCopy, ind, sizeof(ind));
+  memcpy(instCopy, inst, sizeof(inst));
+  memcpy(shiftCopy, shift, sizeof(shift));
+
+  long calls = 0;
+  double start = now();
+  do {
+    findDonors();
+    calls++;
+  } while (now() - start < minTime);
+  result("findDonors", calls, now() - start, "call");
+
+  calls = 0;
+  start = now();
+  do {
+    memcpy(ind, indCopy, sizeof(ind));
+    memcpy(inst, instCopy, sizeof(inst));
+    memcpy(shift, shiftCopy, sizeof(shift));
+    calls++;
+  } while (now() - start < minTime);
+  double restore = (now() - start)/calls;
+  result("(restore)", calls, now() - start, "call");
+
+  calls = 0;
+  start = now();
+  do {
+    memcpy(ind, indCopy, sizeof(ind));
+    memcpy(inst, instCopy, sizeof(inst));
+    memcpy(shift, shiftCopy, sizeof(shift));
+    donationTime();
+    calls++;
+  } while (now() - start < minTime);
+  result("donationTime", calls, now() - start - restore*calls, "call");
+}
+
+/*************************************************************************/
+void benchSolveSeed() {
+  long calls = 0;
+  double start = now();
+  do {
+    solveSeed(calls++ % 1000000);
+  } while (now() - start < minTime);
+  result("solveSeed", calls, now() - start, "seed");
+}
+
+/*************************************************************************/
+void benchScan(struct problem *problem, int nSeeds) {
+  struct solver *solver = newSolver(problem, 1);
+  struct result *results = calloc(nSeeds, sizeof(struct result));
+  double start = now();
+  solveRange(solver, 0, nSeeds, results);
+  double seconds = now() - start;
+  free(results);
+  freeSolver(solver);
+  result("scan", nSeeds, seconds, "seed");
+  tee(NULL, "%-20s %10.1f seeds/s\n", "", nSeeds/seconds);
+}
+
+/*************************************************************************/
+int main(int argc, char *argv[]) {
+
+  struct synthParams p;
+  synthDefaults(&p, NSHIFTS);
+  char *dir = NULL;
+  bool existing = false;
+  bool generateOnly = false;
+  int nSeeds = 1000;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:egs:i:r:R:c:x:z:S:n:m:")) != -1) {
+    switch (opt) {
+    case 'd' : dir = optarg; break;
+    case 'e' : existing = true; break;
+    case 'g' : generateOnly = true; break;
+    case 's' : p.shifters = atoi(optarg); break;
+    case 'i' : p.institutions = atoi(optarg); break;
+    case 'r' : p.density = atof(optarg); break;
+    case 'R' : p.density2 = atof(optarg); break;
+    case 'c' : p.consec = atof(optarg); break;
+    case 'x' : p.special = atof(optarg); break;
+    case 'z' : p.zeroQuota = atof(optarg); break;
+    case 'S' : p.seed = atoi(optarg); break;
+    case 'n' : nSeeds = atoi(optarg); break;
+    case 'm' : minTime = atof(optarg); break;
+    default :
+      printf("usage: %s [-d DIR] [-e] [-g] [-s shifters] [-i institutions]"
+             " [-r density]\n       [-R density2] [-c consec] [-x special]"
+             " [-z zeroQuota] [-S seed]\n       [-n seeds] [-m seconds]\n",
+             argv[0]);
+      exit(1);
+    }
+  }
+  if (p.shifters > MAXIND || p.institutions >= MAXINST) {
+    printf("%d shifters and %d institutions need a build with MAXIND and "
+           "MAXINST of at least %d and %d\n", p.shifters, p.institutions,
+           p.shifters, p.institutions + 1);
+    exit(1);
+  }
+
+  char temp[] = "/tmp/benchXXXXXX";
+  if (dir == NULL) {
+    if (existing || (dir = mkdtemp(temp)) == NULL) {
+      printf("No input directory\n");
+      exit(1);
+    }
+  }
+  if (! existing) mkdir(dir, 0777);   // may be there already
+  if (! existing && synthWrite(dir, &p) != 0) {
+    printf("Could not write the inputs in %s\n", dir);
+    exit(1);
+  }
+  if (generateOnly) {
+    printf("Inputs for %d shifts written in %s\n", NSHIFTS, dir);
+    return 0;
+  }
+  if (chdir(dir) != 0) {
+    printf("Could not use the directory %s\n", dir);
+    exit(1);
+  }
+
+  startWriter();
+  atexit(stopWriter);
+  struct problem *problem = loadProblem(".", "fail", NULL, 0);
+  loadSeed(0);
+  tee(NULL, "%d shifts, %d shifters, %d institutions, %d points, "
+      "%d requested, in %s\n\n", NSHIFTS, nInd + 1, nInst, totPoints,
+      totRequests, dir);
+
+  benchQualified();
+  benchPrepareShifts();
+  benchPrepareConsecutive();
+  benchDonation();
+  benchSolveSeed();
+  benchScan(problem, nSeeds);
+  stopWriter();
+  return 0;
+}
@@ -0,0 +1,306 @@
+//  Checks that the fast engine makes the same decisions as the reference.
+
+/* equiv runs every seed of a range twice, once with the reference engine
+   (the algorithm exactly as written) and once with the fast engine, and
+   compares the decision traces event by event, then the final
+   assignment of every shift.  For a seed that diverges it reports the
+   first decision that differs: the kind of decision, the shift, the
+   requester and the priority in both engines.  The exit status is 1 if
+   any seed diverged, so it can run in CI.
+
+   The input is read once into a problem (see assign.h) and the seeds are
+   shared out among worker processes.
+
+   With -u the rule sets (see rules in assign.c) are checked as well: 
+   under each of ruleSets every seed must decide alike with the copy of 
+   the checks compiled for it and with the generic copy, given the same 
+   values at another address, and the two engines must agree under each
+   of ruleSets and under otherRules, every rule the other way.  Each rule
+   set but the default must also change the assignment of some of the 
+   first 100 seeds, or the rule sets are not in effect.
+
+     gcc -O2 -pthread -o equiv equiv.c synth.c -lm
+
+   Options:
+     -d DIR     the inputs are in DIR (default: the current directory)
+     -g         write a synthetic problem in DIR first (see synth.c)
+     -S N       seed of the synthetic problem (default 1)
+     -s N       shifters of the synthetic problem
+     -r F       LoP-1 request density of the synthetic problem
+     -c F       consecutive fraction of the synthetic problem
+     -f N       first seed index (default 0)
+     -n N       number of seeds (default 100000)
+     -w N       number of worker processes (default: the number of cpus)
+     -l N       report at most N diverging seeds per worker (default 10)
+     -u         check the rule sets too */
+
+#define ASSIGN_LIBRARY    // assign.c without its main
+#include "assign.c"
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "synth.h"
+
+struct run {              // what a seed did in one engine
+  int nEvents;
+  struct event events[RING];
+  int assigned[NSHIFTS];  // -1 for an open shift
+  int openShifts, chisq, chisqInd;
+};
+
+struct run runs[2];       // reference and fast
+struct problem *problem;  // the input, read once
+
+const struct rules otherRules = {"other", "8h", {1, 2, 4, 6}, false, 
+  false, false, 3, 1, true}; // every rule the other way
+#define NCHECKED (NRULESETS + 1)  // each of ruleSets, then otherRules 
+const struct rules *checked[NCHECKED];
+struct rules sameRules[NRULESETS];  /* the values of each of ruleSets at 
+                                       another address, so the checks 
+                                       take their generic copy */
+struct problem *ruleProblem[NCHECKED];  // the input, read under each
+
+/*************************************************************************/
+void useRules(const struct rules *r) {
+  rules = r;
+  setPattern(pattern->name);          // the rest days are those of r
+}
+
+/*************************************************************************/
+void runEngine(int seedIndex, engineType e, struct run *r) {
+  engine = e;
+  solveProblem(problem, seedIndex);  // empties the ring first
+  report();
+  r->nEvents = ringCount;
+  int n = ringCount < RING ? ringCount : RING;
+  int first = ringCount <= RING ? 0 : ringCount & (RING - 1);
+  for (int k = 0; k < n; k++) r->events[k] = ring[(first + k) & (RING - 1)];
+  for (int is = 0; is < NSHIFTS; is++)
+    r->assigned[is] = shift[is].open ? -1 : shift[is].assigned;
+  r->openShifts = openShifts;
+  r->chisq = chisq;
+  r->chisqInd = chisqInd;
+}
+
+/*************************************************************************/
+void showEvent(char *engineName, struct event *e) {
+  const char *kind[7] = {"lop", "consecutive", "assign", "trade", "kill",
+                         "caution", "donate"};
+  tee(NULL, "    %-9s %-11s shift %4d  who %4d  other %4d  aux %3d  "
+      "value %.9g\n", engineName, e->type < 7 ? kind[e->type] : "?",
+      e->shift, e->who, e->other, e->aux, e->value);
+}
+
+/*************************************************************************/
+bool sameRuns(int seedIndex, bool show, char *nameA, char *nameB) {
+
+  // returns true if the two runs made the same decisions and assignment
+
+  struct run *a = &runs[0], *b = &runs[1];
+  int n = a->nEvents < b->nEvents ? a->nEvents : b->nEvents;
+  if (n > RING) n = RING;               // only the last events were kept
+  int k = 0;
+  while (k < n && memcmp(&a->events[k], &b->events[k],
+                         sizeof(struct event)) == 0) k++;
+  if (k < n || a->nEvents != b->nEvents) {
+    if (show) {
+      tee(NULL, "seed %d: decision %d is the first that differs "
+          "(%d and %d decisions)\n", seedIndex, k, a->nEvents, b->nEvents);
+      if (k < n) {
+        showEvent(nameA, &a->events[k]);
+        showEvent(nameB, &b->events[k]);
+      }
+      else tee(NULL, "    one engine stopped early\n");
+      teeFlush();
+    }
+    return false;
+  }
+  for (int is = 0; is < NSHIFTS; is++) {
+    if (a->assigned[is] == b->assigned[is]) continue;
+    if (show) {
+      tee(NULL, "seed %d: same decisions but shift %d went to %d and %d "
+          "(%s, %s)\n", seedIndex, is, a->assigned[is], b->assigned[is],
+          nameA, nameB);
+      teeFlush();
+    }
+    return false;
+  }
+  if (a->openShifts != b->openShifts || a->chisq != b->chisq ||
+      a->chisqInd != b->chisqInd) {
+    if (show) {
+      tee(NULL, "seed %d: same assignment but a different report "
+          "(%s, %s)\n", seedIndex, nameA, nameB);
+      teeFlush();
+    }
+    return false;
+  }
+  return true;
+}
+
+/*************************************************************************/
+bool compareSeed(int seedIndex, bool show) {  // returns true if the same
+  runEngine(seedIndex, REFERENCE, &runs[0]);
+  runEngine(seedIndex, FAST, &runs[1]);
+  return sameRuns(seedIndex, show, "reference", "fast");
+}
+
+/*************************************************************************/
+void useChecked(int k) {  // the rule set k of checked, and its input 
+  problem = ruleProblem[k];
+  useRules(checked[k]);
+}
+
+/*************************************************************************/
+bool compareRules(int seedIndex, bool show) {  // returns true if they agree
+  bool same = true;
+  for (int k = 0; k < NCHECKED && same; k++) {
+    useChecked(k);
+    if (k > 0) same = compareSeed(seedIndex, show);  // 0 is the default
+    if (k >= NRULESETS || ! same) continue;
+    runEngine(seedIndex, FAST, &runs[0]);
+    useRules(&sameRules[k]);
+    runEngine(seedIndex, FAST, &runs[1]);
+    same = sameRuns(seedIndex, show, "inlined", "generic");
+  }
+  useChecked(0);
+  return same;
+}
+
+/*************************************************************************/
+void loadProblems(bool checkRules) {  // the input, under each rule set 
+  problem = loadProblem(".", "fail", NULL, 0);
+  if (! checkRules) return;
+  for (int k = 0; k < NCHECKED; k++) {
+    checked[k] = k < NRULESETS ? ruleSets[k] : &otherRules;
+    if (k < NRULESETS) sameRules[k] = *ruleSets[k];
+    useRules(checked[k]);
+    ruleProblem[k] = k == 0 ? problem : loadProblem(".", "fail", NULL, 0);
+  }
+  useChecked(0);
+}
+
+/*************************************************************************/
+int rulesDiffer(int first, int nSeeds) {
+
+  /* returns the fewest seeds whose assignment a rule set changes from
+     the default's, over the others of checked */
+
+  startWriter();
+  loadProblems(true);
+  tracing = true;
+  int fewest = nSeeds;
+  for (int k = 1; k < NCHECKED; k++) {
+    int differ = 0;
+    for (int s = first; s < first + nSeeds; s++) {
+      useChecked(0);
+      runEngine(s, FAST, &runs[0]);
+      useChecked(k);
+      runEngine(s, FAST, &runs[1]);
+      differ += memcmp(runs[0].assigned, runs[1].assigned, 
+                       sizeof(runs[0].assigned)) != 0;
+    }
+    printf("%s changes %d of %d assignments\n", checked[k]->name, differ,
+           nSeeds);
+    if (differ < fewest) fewest = differ;
+  }
+  useChecked(0);
+  stopWriter();
+  fflush(stdout);
+  return fewest;
+}
+
+/*************************************************************************/
+int worker(int id, int nWorkers, int first, int nSeeds, int limit, 
+           bool checkRules) {
+
+  // returns the number of diverging seeds, at most 255
+
+  startWriter();
+  loadProblems(checkRules);
+  tracing = true;                     // fills the ring, writes nothing
+  int bad = 0;
+  for (int s = first + id; s < first + nSeeds; s += nWorkers)
+    if (! compareSeed(s, bad < limit) 
+        || (checkRules && ! compareRules(s, bad < limit))) bad++;
+  stopWriter();
+  return bad < 255 ? bad : 255;
+}
+
+/*************************************************************************/
+int main(int argc, char *argv[]) {
+
+  struct synthParams p;
+  synthDefaults(&p, NSHIFTS);
+  char *dir = ".";
+  bool generate = false;
+  int first = 0;
+  int nSeeds = 100000;
+  int nWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+  int limit = 10;
+  bool checkRules = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:gS:s:r:c:f:n:w:l:u")) != -1) {
+    switch (opt) {
+    case 'd' : dir = optarg; break;
+    case 'g' : generate = true; break;
+    case 'S' : p.seed = atoi(optarg); break;
+    case 's' : p.shifters = atoi(optarg); break;
+    case 'r' : p.density = atof(optarg); break;
+    case 'c' : p.consec = atof(optarg); break;
+    case 'f' : first = atoi(optarg); break;
+    case 'n' : nSeeds = atoi(optarg); break;
+    case 'w' : nWorkers = atoi(optarg); break;
+    case 'l' : limit = atoi(optarg); break;
+    case 'u' : checkRules = true; break;
+    default :
+      printf("usage: %s [-d DIR] [-g] [-S seed] [-s shifters] [-r density]"
+             " [-c consec]\n       [-f first] [-n seeds] [-w workers]"
+             " [-l limit] [-u]\n", argv[0]);
+      exit(1);
+    }
+  }
+  if (nWorkers < 1) nWorkers = 1;
+  if (first < 0 || first + nSeeds > 1000000) {
+    printf("The seed indices go from 0 to 999999\n");
+    exit(1);
+  }
+  if (generate) {
+    mkdir(dir, 0777);                 // may be there already
+    if (p.shifters > MAXIND || synthWrite(dir, &p) != 0) {
+      printf("Could not write a synthetic problem in %s\n", dir);
+      exit(1);
+    }
+  }
+  if (chdir(dir) != 0) {
+    printf("Could not use the directory %s\n", dir);
+    exit(1);
+  }
+  fflush(stdout);
+
+  int differ = 0;
+  int status;
+  if (checkRules) {                   // in a process of its own, as below
+    int nDiffer = nSeeds < 100 ? nSeeds : 100;
+    if (fork() == 0) exit(rulesDiffer(first, nDiffer));
+    wait(&status);
+    differ = WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+  }
+
+  double start = now();
+  for (int id = 0; id < nWorkers; id++)
+    if (fork() == 0) 
+      exit(worker(id, nWorkers, first, nSeeds, limit, checkRules));
+  int bad = 0;
+  while (wait(&status) > 0)
+    bad += WIFEXITED(status) ? WEXITSTATUS(status) : 255;
+
+  printf("%d seeds from %d, %d workers, %.1f s: ", nSeeds, first, nWorkers,
+         now() - start);
+  if (bad) printf("%d%s diverged\n", bad, bad >= 255 ? " or more" : "");
+  else printf("the engines agree\n");
+  if (checkRules && differ == 0) {
+    printf("A rule set changes no assignment: the rule sets are not in "
+           "effect\n");
+    return 1;
+  }
+  return bad ? 1 : 0;
+}
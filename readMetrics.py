@@ -0,0 +1,75 @@
+# =========================================== #
+#                                             #
+# ICARUS shift assigment                      #
+#                                             #
+# Reader of the metrics file of a scan        #
+# (assign --metrics=FILE)                     #
+#                                             #
+# =========================================== #
+
+# The file is a header and one column per metric with an entry for every
+# seed (see the metrics file in assign.c).  readMetrics maps it and
+# returns the columns by name, as NumPy arrays when NumPy is there and
+# as memoryviews otherwise; nothing is copied, so 1,000,000 seeds load
+# at once.  Only the seeds whose 'ran' entry is 1 have been run.
+#
+#     python readMetrics.py Metrics.bin       a summary of each column
+#
+#     import readMetrics
+#     m = readMetrics.readMetrics('Metrics.bin')
+#     ran = m['ran'] == 1
+#     chisq = m['chisq'][ran]
+
+import mmap
+import struct
+import sys
+
+HEADER = struct.Struct('=8s4i')     # magic, version, seeds, columns, reserved
+COLUMN = struct.Struct('=16s2iq')   # name, type, reserved, offset
+SIZE = {'b': 1, 'i': 4, 'f': 4}
+VIEW = {'b': 'B', 'i': 'i', 'f': 'f'}
+
+
+def readMetrics(fileName):
+
+    with open(fileName, 'rb') as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    magic, version, nSeeds, nColumns, _ = HEADER.unpack_from(data, 0)
+    if magic != b'ASGNMETR' or version != 1:
+        raise ValueError('%s is not a metrics file' % fileName)
+    try:
+        import numpy
+    except ImportError:
+        numpy = None
+    columns = {}
+    for c in range(nColumns):
+        name, kind, _, offset = COLUMN.unpack_from(data, HEADER.size + c*COLUMN.size)
+        name = name.rstrip(b'\0').decode()
+        kind = chr(kind)
+        view = memoryview(data)[offset:offset + SIZE[kind]*nSeeds]
+        if numpy is not None:
+            columns[name] = numpy.frombuffer(view, dtype=VIEW[kind])
+        else:
+            columns[name] = view.cast(VIEW[kind])
+    return columns
+
+
+def summary(columns):
+
+    ran = [k for k, r in enumerate(columns['ran']) if r]
+    print('%d seeds run' % len(ran))
+    if not ran:
+        return
+    for name, values in columns.items():
+        if name == 'ran':
+            continue
+        picked = [values[k] for k in ran]
+        print('%-12s min %12.6g  mean %12.6g  max %12.6g' %
+              (name, min(picked), sum(picked)/len(picked), max(picked)))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        print('usage: python readMetrics.py FILE')
+        sys.exit(1)
+    summary(readMetrics(sys.argv[1]))
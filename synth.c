@@ -0,0 +1,206 @@
+//  Writes a synthetic shift assignment problem.
+
+/* synthWrite produces the 4 input files of assign.c (Inst.csv, Shift.csv,
+   Pri.csv and Ind.csv) in a directory, in the same format as the real
+   ones, at whatever scale is asked for.  The shifts follow the usual
+   pattern of a night, a day and a swing shift every day, with more points
+   for nights and weekends.  Institutions have very different sizes, as
+   they do in the collaboration, and the quotas are proportional to the
+   size and add up to the total number of points.  Shifters ask for about
+   their share of the points and request a fraction of the shifts, with a
+   preference for one type of shift.
+
+   The generator has its own random numbers, so it does not disturb the
+   ones of the algorithm. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "synth.h"
+
+static unsigned long long state;   // state of the generator
+
+/*************************************************************************/
+static double uniform() {          // returns a number in [0,1)
+  state ^= state >> 12;            // xorshift64*
+  state ^= state << 25;
+  state ^= state >> 27;
+  return ((state * 2685821657736338717ULL) >> 11) * (1.0/9007199254740992.0);
+}
+
+/*************************************************************************/
+static int pick(int n) {           // returns an integer in [0,n)
+  return (int)(uniform()*n);
+}
+
+/*************************************************************************/
+void synthDefaults(struct synthParams *p, int shifts) {
+
+  // roughly the size of the 2020 ICARUS period
+
+  p->shifts = shifts;
+  p->shifters = 4*shifts/3;
+  p->institutions = shifts/8 + 2;
+  p->density = 0.25;
+  p->density2 = 0.15;
+  p->consec = 0.2;
+  p->special = 0.3;
+  p->zeroQuota = 0.05;
+  p->seed = 1;
+}
+
+#ifndef NSHIFTS          // as in assign.c, and set the same way 
+#define NSHIFTS 90
+#endif
+
+static const char *type[3] = {"Night", "Day", "Swing"};
+
+/*************************************************************************/
+static FILE *openIn(const char *dir, const char *file) {
+  char name[1024];
+  snprintf(name, sizeof(name), "%s/%s", dir, file);
+  return fopen(name, "w");
+}
+
+/*************************************************************************/
+static int writeShifts(const char *dir, const struct synthParams *p,
+                       int *points, int *totPoints) {
+
+  // Shift.csv: date, type, stype, points, ECL type, ECL date
+
+  const char *month[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul",
+                           "Aug", "Sep", "Oct", "Nov", "Dec"};
+  const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  FILE *fp = openIn(dir, "Shift.csv");
+  if (fp == NULL) return -1;
+  *totPoints = 0;
+  int m = 0, d = 0, y = 2021;
+  for (int is = 0; is < p->shifts; is++) {
+    int day = is/3;
+    int st = is%3;
+    int weekend = (day%7 >= 5);
+    points[is] = (weekend || st == 0) ? 15 : 10;
+    *totPoints += points[is];
+    fprintf(fp, "%s%02d-%s,%s,%d,%d,%s %s,%d-%02d-%02d", is ? "\r" : "",
+            d + 1, month[m], type[st], st, points[is],
+            weekend ? "Weekend" : "Weekday", type[st], y, m + 1, d + 1);
+    if (st == 2 && ++d == mdays[m]) {
+      d = 0;
+      if (++m == 12) {m = 0; y++;}
+    }
+  }
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*************************************************************************/
+static int writeInst(const char *dir, const struct synthParams *p,
+                     int totPoints, double *size, int *quota, 
+                     double *totSize) {
+
+  /* Inst.csv: name and quota.  Sizes follow a power law; the quotas are
+     rounded so that they add up to the total number of points. */
+
+  int nInst = p->institutions;
+  *totSize = 0;
+  for (int i = 1; i <= nInst; i++) {
+    size[i] = 1.0/pow(i, 0.8);
+    *totSize += size[i];
+  }
+  double quotaSize = 0;             // size of the institutions with quota
+  for (int i = 1; i <= nInst; i++) {
+    quota[i] = (uniform() < p->zeroQuota && i > 1) ? 0 : 1;
+    if (quota[i]) quotaSize += size[i];
+  }
+  int given = 0;
+  for (int i = 1; i <= nInst; i++) {
+    if (quota[i]) quota[i] = (int)(totPoints*size[i]/quotaSize);
+    given += quota[i];
+  }
+  quota[1] += totPoints - given;    // the largest takes the remainder
+  FILE *fp = openIn(dir, "Inst.csv");
+  if (fp == NULL) return -1;
+  for (int i = 1; i <= nInst; i++)
+    fprintf(fp, "%sInst%d,%d", i > 1 ? "\r" : "", i, quota[i]);
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*************************************************************************/
+static int writeInd(const char *dir, const struct synthParams *p,
+                    int totPoints, const double *size, double totSize) {
+
+  // Ind.csv and Pri.csv
+
+  int nInst = p->institutions;
+  FILE *fp = openIn(dir, "Ind.csv");
+  FILE *fq = openIn(dir, "Pri.csv");
+  if (fp == NULL || fq == NULL) {
+    if (fp) fclose(fp);
+    if (fq) fclose(fq);
+    return -1;
+  }
+  int nPri = 0;
+  double share = (double)totPoints/p->shifters;   // points per shifter
+  for (int ii = 0; ii < p->shifters; ii++) {
+    double r = uniform()*totSize;    // home institution by size
+    int home = 1;
+    while (home < nInst && (r -= size[home]) > 0) home++;
+    int request = 5*(int)(share*(1.0 + 2.0*uniform())/5 + 0.5);  // twice
+    if (request < 10) request = 10;                          // oversubscribed
+    if (uniform() < 0.03) request = 0;
+    int consec = uniform() < p->consec ? 1 : 2;
+    int special = uniform() < p->special ? 1 : 2;
+    int spread = uniform() < 0.3 ? 1 : 2;
+    fprintf(fp, "%sShifter %d,ecl%05d,shifter%d@example.org,%d,%d,,%d,%d,%d,"
+            "%d,%d,%d,%d,%d,%s", ii ? "\r" : "", ii, ii, ii, home, request,
+            1 + pick(2), consec, 1 + pick(2), 1 + pick(2), spread,
+            spread == 1 ? 1 + pick(3) : 0, uniform() < 0.1 ? 1 : 2, special,
+            special == 1 ? "teaching" : "");
+    if (special == 1)
+      fprintf(fq, "%secl%05d,%c", nPri++ ? "\r" : "", ii, "NLMHX"[pick(5)]);
+
+    // LoP-1, then the extra LoP-2 requests, favouring one type of shift
+
+    int favorite = pick(3);
+    for (int lop = 1; lop <= 2; lop++) {
+      double density = lop == 1 ? p->density : p->density2;
+      for (int is = 0; is < p->shifts; is++) {
+        double odds = density*(is%3 == favorite ? 1.6 : 0.7);
+        fprintf(fp, uniform() < odds ? ",1" : ",");
+      }
+    }
+    fprintf(fp, ",%d", ii);          // the response ID
+  }
+  if (nPri == 0) fprintf(fq, "nobody,N");
+  int failed = fclose(fp) != 0;
+  failed |= fclose(fq) != 0;
+  return failed ? -1 : 0;
+}
+
+/*************************************************************************/
+int synthWrite(const char *dir, const struct synthParams *p) {
+
+  /* returns 0 on success, -1 if the parameters do not make a problem for
+     this build (shifts other than NSHIFTS, no institution or shifter) or
+     a file could not be written */
+
+  if (p->shifts != NSHIFTS || p->institutions < 1 || p->shifters < 1) 
+    return -1;
+  state = 0x9E3779B97F4A7C15ULL ^ p->seed;
+  if (state == 0) state = 1;
+
+  int *points = malloc(p->shifts*sizeof(int));
+  double *size = calloc(p->institutions + 1, sizeof(double));
+  int *quota = calloc(p->institutions + 1, sizeof(int));
+  int totPoints = 0;
+  double totSize = 0;
+  int status = -1;
+  if (points && size && quota &&
+      writeShifts(dir, p, points, &totPoints) == 0 &&
+      writeInst(dir, p, totPoints, size, quota, &totSize) == 0 &&
+      writeInd(dir, p, totPoints, size, totSize) == 0) status = 0;
+  free(points);
+  free(size);
+  free(quota);
+  return status;
+}
@@ -0,0 +1,22 @@
+//  Synthetic shift assignment problems for the benchmark and the
+//  equivalence harness.  See synth.c.
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+struct synthParams {
+  int shifts;              // number of shifts; must match NSHIFTS
+  int shifters;            // number of individuals
+  int institutions;        // number of institutions
+  double density;          // fraction of the shifts requested at LoP-1
+  double density2;         // extra fraction requested at LoP-2
+  double consec;           // fraction asking for consecutive shifts
+  double special;          // fraction asking for special priority
+  double zeroQuota;        // fraction of institutions with zero quota
+  unsigned seed;           // seed of the generator
+};
+
+void synthDefaults(struct synthParams *p, int shifts);
+int synthWrite(const char *dir, const struct synthParams *p);
+
+#endif